@@ -5,6 +5,7 @@ layout (triangle_strip, max_vertices = 3) out;
 in Data
 {
     vec2 fragmentTextureUV;
+    float fragmentTextureLayer;
     vec3 vertexPosition_Camera;
     vec3 normal_Camera;
 } vertex_in[];
@@ -15,6 +16,7 @@ uniform mat4 inverseProjectionMatrix;   // homogenous -> camera
 out Data
 {
     vec2 fragmentTextureUV;
+    float fragmentTextureLayer;
     vec3 vertexPosition_Camera;
     vec3 normal_Camera;
 } geometry_out;
@@ -44,6 +46,7 @@ void main()
     for(i = 0;i < gl_in.length();i++)
     {
         geometry_out.fragmentTextureUV       = vertex_in[i].fragmentTextureUV;
+        geometry_out.fragmentTextureLayer    = vertex_in[i].fragmentTextureLayer;
         geometry_out.vertexPosition_Camera   = /*vertex_in[i].vertexPosition_Camera;*/ vec3(inverseProjectionMatrix * newCentre_Homogeneous[i]);
         geometry_out.normal_Camera           = vertex_in[i].normal_Camera;
 
@@ -0,0 +1,46 @@
+#version 330 core
+layout (lines) in;
+layout (triangle_strip, max_vertices = 4) out;
+
+in Path
+{
+    vec2 position_Model;
+    vec2 normal_Model;
+} path_in[];
+
+// input data that is constant for whole mesh
+uniform mat4 MV;                    // model -> camera
+uniform mat4 MVP;                   // model -> homogenous
+uniform mat3 normalMV;              // model -> camera (for normals) = mat3(transpose(inverse(MV)))
+uniform float wallHeight;           // goes down as the trail fades
+
+out Data
+{
+    vec2 fragmentTextureUV;
+    float fragmentTextureLayer;
+    vec3 vertexPosition_Camera;
+    vec3 normal_Camera;
+} geometry_out;
+
+void emitWallVertex(int i, float height)
+{
+    vec4 position_Model = vec4(path_in[i].position_Model.x, height, path_in[i].position_Model.y, 1.0);
+
+    gl_Position = MVP * position_Model;
+    geometry_out.fragmentTextureUV = vec2(0.0, 0.0);
+    geometry_out.fragmentTextureLayer = -1.0;
+    geometry_out.vertexPosition_Camera = (MV * position_Model).xyz;
+    geometry_out.normal_Camera = normalize(normalMV * vec3(path_in[i].normal_Model.x, 0.0, path_in[i].normal_Model.y));
+    EmitVertex();
+}
+
+void main()
+{
+    // each line along the path becomes a wall going up from y = 0
+    // bottom then top of the start of the line, then the same for the end
+    emitWallVertex(0, 0.0);
+    emitWallVertex(0, wallHeight);
+    emitWallVertex(1, 0.0);
+    emitWallVertex(1, wallHeight);
+    EndPrimitive();
+}
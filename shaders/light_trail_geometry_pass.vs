@@ -0,0 +1,21 @@
+#version 330
+// Input vertex data, different for all executions of this shader.
+in vec2 pathPosition_Model;         // x and z of a point along the trail, packed to 0 -> 1
+in vec4 pathNormal_Model;           // x and z of the wall's normal there
+
+// input data that is constant for whole mesh
+uniform vec2 positionOrigin;        // unpacks pathPosition_Model
+uniform vec2 positionScale;
+
+// output to geometry shader, which builds the walls
+out Path
+{
+    vec2 position_Model;
+    vec2 normal_Model;
+};
+
+void main()
+{
+    position_Model = positionOrigin + (pathPosition_Model * positionScale);
+    normal_Model = normalize(pathNormal_Model.xy);
+}
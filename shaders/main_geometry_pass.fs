@@ -4,6 +4,7 @@
 in Data
 {
     vec2 fragmentTextureUV;
+    float fragmentTextureLayer;
     vec3 vertexPosition_Camera;
     vec3 normal_Camera;
 };
@@ -11,6 +12,7 @@ in Data
 // const input per mesh
 uniform float fragmentIsTexture;
 uniform sampler2D textureSampler;
+uniform sampler2DArray textureArraySampler;
 uniform vec3 fragmentColour;
 
 // outputs - MRT (multiple render targets)
@@ -24,7 +26,10 @@ void main()
     outNormal_Camera = normal_Camera;
 
     // get the colour of this point, either based on texture or input colour
+    vec4 textureColour = (fragmentTextureLayer < 0.0f) ?
+                            texture(textureSampler, fragmentTextureUV) :
+                            texture(textureArraySampler, vec3(fragmentTextureUV, fragmentTextureLayer));
     outMaterialColour.rgb = vec3((fragmentIsTexture > 0.5f) ?
-                                    texture(textureSampler, fragmentTextureUV) :
+                                    textureColour :
                                     vec4(fragmentColour, 1));
 }
@@ -3,6 +3,7 @@
 in vec3 vertexPosition_Model;
 in vec3 vertexNormal_Model;
 in vec2 vertexTextureUV;
+in float vertexTextureLayer;        // which layer of the texture array, -1 if it's not in one
 
 // input data that is constant for whole mesh
 uniform mat4 MV;                    // model -> camera
@@ -13,6 +14,7 @@ uniform mat3 normalMV;              // model -> camera (for normals) = mat3(tran
 out Data
 {
     vec2 fragmentTextureUV;
+    float fragmentTextureLayer;
     vec3 vertexPosition_Camera;
     vec3 normal_Camera;
 };
@@ -30,5 +32,6 @@ void main()
 
     // pass values to fragment shader
     fragmentTextureUV = vertexTextureUV;
+    fragmentTextureLayer = vertexTextureLayer;
 }
 
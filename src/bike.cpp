@@ -2,6 +2,8 @@
 #include "shader.hpp"
 #include "world.hpp"
 #include "light_trail_manager.hpp"
+#include "heading.hpp"
+#include "mesh_batch.hpp"
 
 #include <set>
 
@@ -11,11 +13,15 @@ Bike::Bike(std::shared_ptr<const ObjData3D> _objData,
            std::shared_ptr<World> _world,
            std::shared_ptr<const Shader> _shader,
            std::shared_ptr<const Shader> _explodeShader,
+           std::shared_ptr<const Shader> _trailShader,
            const glm::mat4 &modelMat,
            const glm::vec3 &_defaultColour)
     : Object(_objData, _world, _shader, modelMat, _defaultColour),
-      bikeAngleAroundYRads(0.0f), wheelAngle(0.0f), engineAngle(0.0f),
-      trailManager(std::make_shared<LightTrailManager>(_world, _shader, _defaultColour)),
+      initialModelMatrix(modelMat), position(0.0f), heading(0),
+      wheelAngle(0.0f), engineAngle(0.0f),
+      // the bike moves speed units along it's Z axis per frame, the length of
+      // the model matrix Z axis tells us how far that is in world co-ords
+      trailManager(std::make_shared<LightTrailManager>(_world, _trailShader, _shader, _defaultColour, glm::length(glm::vec3(modelMat[2])))),
       speed(BIKE_SPEED_DEFAULT), explodeShader(_explodeShader),
       explodeLevel(0.0f), exploding(false)
 {
@@ -30,10 +36,25 @@ Bike::~Bike()
 {
 }
 
+void Bike::updateModelMatrix()
+{
+    // rotate around -ve Y by our heading, then translate to position
+    float sinHeading = Heading::sin(heading);
+    float cosHeading = Heading::cos(heading);
+    glm::mat4 local(glm::vec4(cosHeading,  0.0f, sinHeading, 0.0f),
+                    glm::vec4(0.0f,        1.0f, 0.0f,       0.0f),
+                    glm::vec4(-sinHeading, 0.0f, cosHeading, 0.0f),
+                    glm::vec4(position,    1.0f));
+    modelMatrix = initialModelMatrix * local;
+}
+
 void Bike::updateLocation()
 {
-    const glm::vec3 vec(0,0,-speed);
-    translate(vec);
+    // move speed units forwards
+    glm::vec2 forward = Heading::forward(heading);
+    const glm::vec3 vec(speed * forward.x, 0.0f, speed * forward.y);
+    position += vec;
+    updateModelMatrix();
 
     // calculate wheel spin based on distance travelled
     // TODO calculate?
@@ -59,9 +80,8 @@ void Bike::turn(TurnDirection dir)
         return;
     }
 
-    float angleRads = glm::radians((dir == TURN_RIGHT) ? ANGLE_OF_TURNS : -ANGLE_OF_TURNS);
-    bikeAngleAroundYRads += angleRads;
-    rotate(angleRads, glm::vec3(0,-1,0));
+    heading = Heading::turn(heading, dir);
+    updateModelMatrix();
 }
 
 Accelerating Bike::updateSpeed(Accelerating a)
@@ -153,7 +173,6 @@ void Bike::setExploding()
 
 void Bike::internalDrawAll(const std::vector<std::shared_ptr<Mesh<glm::vec3>>> &meshes) const
 {
-    GLuint explodeID = shader->getUniformID(SHADER_UNIFORM_EXPLODE);
 
     // only draw the bike if not fully exploded
     if (explodeLevel < 1.0f)
@@ -179,52 +198,31 @@ void Bike::internalDrawAll(const std::vector<std::shared_ptr<Mesh<glm::vec3>>> &
                          glm::translate(-leftEngineAxis.point);             // 1st translate axis to origin
 
         // set explode
-        if (explodeID >= 0)
-        {
-            glUniform1f(explodeID, explodeLevel);
-        }
+        shader->setUniform(SHADER_UNIFORM_EXPLODE, explodeLevel);
 
         // front tyre
         world->sendMVP(shader, ftmm);
-        for (auto it : frontTyreMeshIndexes)
-        {
-            drawMesh(meshes[it]);
-        }
+        drawPart(meshes, frontTyreMeshIndexes, frontTyreBatchGroup);
 
         // back tyre
         world->sendMVP(shader, btmm);
-        for (auto it : backTyreMeshIndexes)
-        {
-            drawMesh(meshes[it]);
-        }
+        drawPart(meshes, backTyreMeshIndexes, backTyreBatchGroup);
 
         // left engine
         world->sendMVP(shader, lemm);
-        for (auto it : leftEngineIndexes)
-        {
-            drawMesh(meshes[it]);
-        }
+        drawPart(meshes, leftEngineIndexes, leftEngineBatchGroup);
 
         // right engine
         world->sendMVP(shader, remm);
-        for (auto it : rightengineIndexes)
-        {
-            drawMesh(meshes[it]);
-        }
+        drawPart(meshes, rightengineIndexes, rightEngineBatchGroup);
 
         // everything else
         world->sendMVP(shader, modelMatrix);
-        for (auto it : remainderIndexes)
-        {
-            drawMesh(meshes[it]);
-        }
+        drawPart(meshes, remainderIndexes, remainderBatchGroup);
     }
 
     // light trail
-    if (explodeID >= 0)
-    {
-        glUniform1f(explodeID, 0.0f);
-    }
+    shader->setUniform(SHADER_UNIFORM_EXPLODE, 0.0f);
     trailManager->drawAll();
 }
 
@@ -237,7 +235,7 @@ void Bike::update(TurnDirection turning, Accelerating accelerating, bool stop)
             explodeLevel += 1.0f/30.0f;
         }
         // fade light trail
-        trailManager->update(NO_TURN, SPEED_NORMAL, 0.0f, applyModelMatrx(glm::vec3(0.0f)), bikeAngleAroundYRads);
+        trailManager->update(NO_TURN, SPEED_NORMAL, 0.0f, applyModelMatrx(glm::vec3(0.0f)), heading);
         return;
     }
 
@@ -254,7 +252,7 @@ void Bike::update(TurnDirection turning, Accelerating accelerating, bool stop)
     Accelerating actualAccelerating = updateSpeed(accelerating);
 
     // update the light trail before we change angle or location
-    trailManager->update(turning, actualAccelerating, oldSpeed, applyModelMatrx(glm::vec3(0.0f)), bikeAngleAroundYRads);
+    trailManager->update(turning, actualAccelerating, oldSpeed, applyModelMatrx(glm::vec3(0.0f)), heading);
 
     // update angle
     turn(turning);
@@ -388,6 +386,34 @@ void Bike::initialiseBikeParts()
         }
         i++;
     }
+
+    // copy the parts into one set of buffers, so each is drawn with one draw per texture
+    meshBatch = std::make_unique<MeshBatch>();
+    frontTyreBatchGroup = meshBatch->addGroup(frontTyreMeshIndexes);
+    backTyreBatchGroup = meshBatch->addGroup(backTyreMeshIndexes);
+    leftEngineBatchGroup = meshBatch->addGroup(leftEngineIndexes);
+    rightEngineBatchGroup = meshBatch->addGroup(rightengineIndexes);
+    remainderBatchGroup = meshBatch->addGroup(remainderIndexes);
+    if (!meshBatch->build(*objData))
+    {
+        meshBatch = NULL;
+    }
+}
+
+// draw one of the bike's parts, with the MVP for that part already sent
+void Bike::drawPart(const std::vector<std::shared_ptr<Mesh<glm::vec3>>> &meshes,
+                    const std::vector<unsigned int> &meshIndexes, unsigned int batchGroup) const
+{
+    if (meshBatch)
+    {
+        meshBatch->drawGroup(batchGroup, *shader, defaultColour);
+        return;
+    }
+
+    for (auto it : meshIndexes)
+    {
+        drawMesh(meshes[it]);
+    }
 }
 
 #ifdef DEBUG
@@ -396,18 +422,19 @@ bool bikeStateSaved;
 void Bike::saveBikeState()
 {
     bikeStateSaved = true;
-    savedBikeAngleAroundYRads = bikeAngleAroundYRads;
+    savedHeading = heading;
+    savedPosition = position;
     savedSpeed = speed;
-    savedModelMatrix = modelMatrix;
 }
 
 void Bike::restoreBikeState()
 {
     if (bikeStateSaved)
     {
-        bikeAngleAroundYRads = savedBikeAngleAroundYRads;
+        heading = savedHeading;
+        position = savedPosition;
         speed = savedSpeed;
-        modelMatrix = savedModelMatrix;
+        updateModelMatrix();
     }
 }
 #endif
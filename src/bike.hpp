@@ -6,6 +6,7 @@
 #include "bike_movements.hpp"
 
 class LightTrailManager;
+class MeshBatch;
 class World;
 class Shader;
 
@@ -16,6 +17,7 @@ public:
         std::shared_ptr<World> _world,
         std::shared_ptr<const Shader> _shader,
         std::shared_ptr<const Shader> _explodeShader,
+        std::shared_ptr<const Shader> _trailShader,
         const glm::mat4 &modelMat,
         const glm::vec3 &_defaultColour = glm::vec3(0,0,0));
     ~Bike();
@@ -43,13 +45,21 @@ protected:
     void rotate(float radians, const glm::vec3 &axis) override { Object::rotate(radians, axis); }
     void updateLocation();
     void turn(TurnDirection dir);
+    void updateModelMatrix();
     Accelerating updateSpeed(Accelerating a);
 
     void internalDrawAll(const std::vector<std::shared_ptr<Mesh<glm::vec3>>> &meshes) const override;
 
     void initialiseBikeParts();
+    void drawPart(const std::vector<std::shared_ptr<Mesh<glm::vec3>>> &meshes,
+                  const std::vector<unsigned int> &meshIndexes, unsigned int batchGroup) const;
+
+    // model matrix = initialModelMatrix * translate(position) * rotate(heading)
+    // rebuilt from these each frame, so errors don't build up
+    glm::mat4 initialModelMatrix;
+    glm::vec3 position;         // in model space
+    unsigned int heading;       // see heading.hpp
 
-    float bikeAngleAroundYRads;
     float wheelAngle;
     float engineAngle;
 
@@ -59,6 +69,15 @@ protected:
     std::vector<unsigned int> rightengineIndexes;
     std::vector<unsigned int> remainderIndexes;
 
+    // each part is a group in meshBatch, so it only takes a draw or two.
+    // if we couldn't make it, the meshes are drawn one at a time
+    std::unique_ptr<MeshBatch> meshBatch;
+    unsigned int frontTyreBatchGroup;
+    unsigned int backTyreBatchGroup;
+    unsigned int leftEngineBatchGroup;
+    unsigned int rightEngineBatchGroup;
+    unsigned int remainderBatchGroup;
+
     MeshAxis frontTyreAxis;
     MeshAxis backTyreAxis;
     MeshAxis rightEngineAxis;
@@ -75,9 +94,9 @@ protected:
 
 #ifdef DEBUG
     bool bikeStateSaved;
-    float savedBikeAngleAroundYRads;
+    unsigned int savedHeading;
+    glm::vec3 savedPosition;
     float savedSpeed;
-    glm::mat4 savedModelMatrix;
 #endif
 };
 
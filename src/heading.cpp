@@ -0,0 +1,36 @@
+#include "heading.hpp"
+
+#include <cmath>
+
+float Heading::sinTable[NUM_HEADINGS];
+float Heading::cosTable[NUM_HEADINGS];
+
+void Heading::setup()
+{
+    for (unsigned int i = 0; i < NUM_HEADINGS; i++)
+    {
+        // work it out in double, so the table is as accurate as a float can be
+        double angle = (double)i * 2.0 * 3.14159265358979323846 / NUM_HEADINGS;
+        sinTable[i] = (float)std::sin(angle);
+        cosTable[i] = (float)std::cos(angle);
+    }
+}
+
+unsigned int Heading::turn(unsigned int heading, TurnDirection dir)
+{
+    switch (dir)
+    {
+        case TURN_RIGHT:    return (heading + 1) % NUM_HEADINGS;
+        case TURN_LEFT:     return (heading + NUM_HEADINGS - 1) % NUM_HEADINGS;
+        default:            return heading;
+    }
+}
+
+unsigned int Heading::stepsBetween(unsigned int from, unsigned int to, TurnDirection dir)
+{
+    if (dir == TURN_LEFT)
+    {
+        return (from + NUM_HEADINGS - to) % NUM_HEADINGS;
+    }
+    return (to + NUM_HEADINGS - from) % NUM_HEADINGS;
+}
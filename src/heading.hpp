@@ -0,0 +1,38 @@
+#ifndef __HEADING_HPP
+#define __HEADING_HPP
+
+#include "bike_movements.hpp"
+
+#include <glm/glm.hpp>
+
+// the bike always turns by ANGLE_OF_TURNS, so it can only ever face one of these
+#define NUM_HEADINGS    ((unsigned int)((360.0f / ANGLE_OF_TURNS) + 0.5f))
+
+// Headings are stored as an index rather than an angle. 0 is facing along
+// -ve Z and each step is ANGLE_OF_TURNS to the right. This means headings
+// are exact no matter how long we drive for, and we can look up sin and cos
+// rather than calculating them.
+class Heading
+{
+public:
+    static void setup();
+
+    static unsigned int turn(unsigned int heading, TurnDirection dir);
+    // how many steps we've turned going from 'from' to 'to' in direction dir
+    static unsigned int stepsBetween(unsigned int from, unsigned int to, TurnDirection dir);
+
+    static float radians(unsigned int heading) { return heading * glm::radians(ANGLE_OF_TURNS); }
+    static float sin(unsigned int heading) { return sinTable[heading]; }
+    static float cos(unsigned int heading) { return cosTable[heading]; }
+
+    // unit vector in the XZ plane of the way we are facing
+    static glm::vec2 forward(unsigned int heading) { return glm::vec2(sinTable[heading], -cosTable[heading]); }
+    // unit vector in the XZ plane pointing to our right
+    static glm::vec2 right(unsigned int heading) { return glm::vec2(cosTable[heading], sinTable[heading]); }
+
+protected:
+    static float sinTable[NUM_HEADINGS];
+    static float cosTable[NUM_HEADINGS];
+};
+
+#endif
@@ -29,22 +29,14 @@ void Lamp::draw(const glm::mat4 &projectionMatrix, const glm::mat4 &viewMatrix)
 
     // send MVP
     glm::mat4 mvp = projectionMatrix * viewMatrix * modelMatrix;
-    glUniformMatrix4fv(shader->getUniformID(SHADER_UNIFORM_MVP), 1, GL_FALSE, &mvp[0][0]);
+    shader->setUniform(SHADER_UNIFORM_MVP, mvp);
 
     for (auto &it : meshes)
     {
-        GLuint vertexPosition_ModelID = shader->getAttribID(SHADER_ATTRIB_VERTEX_POS);
+        shader->setUniform(SHADER_UNIFORM_FRAGMENT_COLOUR, colour);
 
-        glEnableVertexAttribArray(vertexPosition_ModelID);
-        glBindBuffer(GL_ARRAY_BUFFER, it->vertexBuffer);
-        glVertexAttribPointer(vertexPosition_ModelID, 3, GL_FLOAT, GL_FALSE, 0, (void *)0);
-
-        glUniform3fv(shader->getUniformID(SHADER_UNIFORM_FRAGMENT_COLOUR),  1, &colour[0]);
-
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, it->indiceBuffer);
-        glDrawElements(GL_TRIANGLES, it->numIndices, GL_UNSIGNED_SHORT, (void *)0);
-
-        glDisableVertexAttribArray(vertexPosition_ModelID);
+        it->bindVertexArray(*shader);
+        glDrawElements(GL_TRIANGLES, it->numIndices, it->indexType, (void *)0);
     }
 }
 
@@ -54,30 +46,22 @@ void Lamp::sendLampData(std::shared_ptr<const Shader> toShader, const glm::mat4
     glm::mat4 mvp = projectionMatrix * viewMatrix * glm::translate(position) * glm::scale(glm::vec3(radiusMultiple*radius, radiusMultiple*radius, radiusMultiple*radius));
     glm::vec3 position_Camera = glm::vec3(viewMatrix * glm::vec4(position, 1.0f));
 
-    glUniformMatrix4fv(toShader->getUniformID(SHADER_UNIFORM_MVP), 1, GL_FALSE, &mvp[0][0]);
-    glUniform3fv(toShader->getUniformID(SHADER_UNIFORM_LIGHT_POS_CAMERA), 1, &position_Camera[0]);
-    glUniform1f(toShader->getUniformID(SHADER_UNIFORM_LIGHT_RADIUS), radius);
-    glUniform3fv(toShader->getUniformID(SHADER_UNIFORM_LIGHT_COLOUR), 1, &colour[0]);
-    glUniform1f(toShader->getUniformID(SHADER_UNIFORM_LIGHT_AMBIENT_FACTOR), ambient);
-    glUniform1f(toShader->getUniformID(SHADER_UNIFORM_LIGHT_DIFFUSE_FACTOR), diffuse);
-    glUniform1f(toShader->getUniformID(SHADER_UNIFORM_LIGHT_SPECULAR_FACTOR), specular);
+    toShader->setUniform(SHADER_UNIFORM_MVP, mvp);
+    toShader->setUniform(SHADER_UNIFORM_LIGHT_POS_CAMERA, position_Camera);
+    toShader->setUniform(SHADER_UNIFORM_LIGHT_RADIUS, radius);
+    toShader->setUniform(SHADER_UNIFORM_LIGHT_COLOUR, colour);
+    toShader->setUniform(SHADER_UNIFORM_LIGHT_AMBIENT_FACTOR, ambient);
+    toShader->setUniform(SHADER_UNIFORM_LIGHT_DIFFUSE_FACTOR, diffuse);
+    toShader->setUniform(SHADER_UNIFORM_LIGHT_SPECULAR_FACTOR, specular);
 
-    GLuint vertexPosition_ModelID = toShader->getAttribID(SHADER_ATTRIB_VERTEX_POS);
-    glUniform1i(toShader->getUniformID(SHADER_UNIFORM_GEOMETRY_TEXTURE_SAMPLER), 0);
-    glUniform1i(toShader->getUniformID(SHADER_UNIFORM_NORMAL_TEXTURE_SAMPLER), 1);
-    glUniform1i(toShader->getUniformID(SHADER_UNIFORM_COLOUR_TEXTURE_SAMPLER), 2);
+    toShader->setUniform(SHADER_UNIFORM_GEOMETRY_TEXTURE_SAMPLER, 0);
+    toShader->setUniform(SHADER_UNIFORM_NORMAL_TEXTURE_SAMPLER, 1);
+    toShader->setUniform(SHADER_UNIFORM_COLOUR_TEXTURE_SAMPLER, 2);
 
     auto dfqMeshes = deferredShadingObj->getMeshes();
     for (auto &it : dfqMeshes)
     {
-        glEnableVertexAttribArray(vertexPosition_ModelID);
-
-        glBindBuffer(GL_ARRAY_BUFFER, it->vertexBuffer);
-        glVertexAttribPointer(vertexPosition_ModelID, 3, GL_FLOAT, GL_FALSE, 0, (void *)0);
-
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, it->indiceBuffer);
-        glDrawElements(GL_TRIANGLES, it->numIndices, GL_UNSIGNED_SHORT, (void *)0);
-
-        glDisableVertexAttribArray(vertexPosition_ModelID);
+        it->bindVertexArray(*toShader);
+        glDrawElements(GL_TRIANGLES, it->numIndices, it->indexType, (void *)0);
     }
 }
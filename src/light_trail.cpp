@@ -1,67 +1,265 @@
 #include "light_trail.hpp"
-#include "light_trail_segment.hpp"
+#include "light_trail_segment_store.hpp"
+#include "light_trail_grid.hpp"
+#include "heading.hpp"
 #include "object.hpp"
+#include "world.hpp"
+#include "shader.hpp"
 
 #include <algorithm>
+#include <iterator>
 
 #include <glm/gtx/transform.hpp>
 
 static const float lightTrailHeight = 1.9f;
 
+// how many points go in the mesh before we seal it into a chunk
+#define LIGHT_TRAIL_CHUNK_POINTS        1024
+
+// sealed chunks also get simplified versions, each allowed LIGHT_TRAIL_LOD_ERROR_STEP
+// times more error than the one before, and we draw the simplest one that's
+// out by less than LIGHT_TRAIL_LOD_MAX_SCREEN_ERROR of the screen's height (about a pixel)
+#define LIGHT_TRAIL_LOD_LEVELS              5
+#define LIGHT_TRAIL_LOD_FIRST_ERROR         0.02f
+#define LIGHT_TRAIL_LOD_ERROR_STEP          4.0f
+#define LIGHT_TRAIL_LOD_MAX_SCREEN_ERROR    0.001f
+
+// how many pairs of segments we try to combine each update
+#define LIGHT_TRAIL_COMPACTION_STEPS    4
+
+// a new segment starts touching the end of the last one, so skip this
+// fraction of the start of each frame's move when checking for self collisions.
+// anything we hit there we'd have hit at the end of the last frame's move.
+#define LIGHT_TRAIL_SELF_COLLISION_SKIP 0.01f
+
 LightTrail::LightTrail(std::shared_ptr<World> _world,
                        std::shared_ptr<const Shader> _shader,
+                       std::shared_ptr<LightTrailSegmentStore> _segmentStore,
+                       std::shared_ptr<LightTrailGrid> _grid,
                        glm::vec3 _colour,
+                       float _worldScale,
+                       float _compactionMaxError,
                        TurnDirection turning,
                        Accelerating accelerating)
-    : world(_world), shader(_shader), colour(_colour),
-      stopping(false), isStopped(false)
+    : world(_world), shader(_shader), segmentStore(_segmentStore), grid(_grid), colour(_colour), worldScale(_worldScale),
+      lightTrailMesh(INVALID_MESH_HANDLE), lightTrailMeshData(NULL), chunkLevels(LIGHT_TRAIL_LOD_LEVELS),
+      selfGrid(std::make_unique<LightTrailGrid>(_segmentStore)),
+      compactionMaxError(_compactionMaxError)
 {
-    state = calculateState(turning, accelerating);
+    start(turning, accelerating);
 }
 
 LightTrail::~LightTrail()
 {
+    removeFromGrid();
+    for (auto ps : pathSegments)
+    {
+        segmentStore->remove(ps);
+    }
+}
+
+void LightTrail::reset()
+{
+    removeFromGrid();
+    for (auto ps : pathSegments)
+    {
+        selfGrid->remove(ps);
+        segmentStore->remove(ps);
+    }
+    pathSegments.clear();
+
+    // sealChunk() and createObject() refill these
+    std::move(sealedChunks.begin(), sealedChunks.end(), std::back_inserter(spareChunks));
+    sealedChunks.clear();
+    if (lightTrailMeshData)
+    {
+        lightTrailMeshData->vertices.clear();
+        lightTrailMeshData->normals.clear();
+    }
+}
+
+void LightTrail::start(TurnDirection turning, Accelerating accelerating)
+{
+    height = lightTrailHeight;
+    selfCollided = false;
+    numCompactedSegments = 0;
+    stopping = false;
+    isStopped = false;
+    state = calculateState(turning, accelerating);
 }
 
-void LightTrail::createObject(glm::vec3 currentLocation, float currentAngleRads)
+void LightTrail::removeFromGrid()
 {
-    MeshData<glm::vec3> &md = lightTrailMeshData;
+    for (auto ps : pathSegments)
+    {
+        grid->remove(ps);
+    }
+}
+
+void LightTrail::createObject(glm::vec3 currentLocation, unsigned int currentHeading)
+{
+    // we only keep the path along the bottom of the walls, as x and z.
+    // the shader builds the walls up from it
+    glm::vec2 point = glm::vec2(currentLocation.x, currentLocation.z);
+    glm::vec2 normal = glm::vec2(Heading::cos(currentHeading), Heading::sin(currentHeading));
+
+    if (lightTrailObjData)
+    {
+        // we've been reset, so reuse the old trail's mesh, its buffers are already big enough
+        lightTrailMeshData->vertices.assign(2, point);      // nearest and furthest
+        lightTrailMeshData->normals.assign(2, normal);
+        lightTrailObjData->markDirty(lightTrailMesh, 0, 2, 0, 0);
+        return;
+    }
 
-    md.indices.empty();
-    md.vertices.empty();
-    md.uvs.empty();
-    md.normals.empty();
-    md.colours.empty();
+    MeshData<glm::vec2> md;
 
     md.name = "LT";
     md.hasTexture = false;
-    //md.texturePath = "light_trail.DDS";
-    md.vertices.push_back(glm::vec3(currentLocation.x, 0.0f,             currentLocation.z));    // bottom nearest
-    md.vertices.push_back(glm::vec3(currentLocation.x, lightTrailHeight, currentLocation.z));    // top nearest
-    md.vertices.push_back(glm::vec3(currentLocation.x, 0.0f,             currentLocation.z));    // bottom furthest
-    md.vertices.push_back(glm::vec3(currentLocation.x, lightTrailHeight, currentLocation.z));    // top furthest
-
-    glm::vec3 normal = glm::normalize(glm::vec3(glm::vec4(1,0,0,1) * glm::rotate(currentAngleRads, glm::vec3(0,-1,0))));
-    md.normals.push_back(normal);
+    md.vertices.push_back(point);    // nearest
+    md.vertices.push_back(point);    // furthest
     md.normals.push_back(normal);
     md.normals.push_back(normal);
-    md.normals.push_back(normal);
-
-    /*md.uvs.push_back(glm::vec2(0.0f, 0.0f));
-    md.uvs.push_back(glm::vec2(0.0f, 1.0f));
-    md.uvs.push_back(glm::vec2(0.1f, 0.0f));
-    md.uvs.push_back(glm::vec2(0.1f, 1.0f));*/
 
-    md.indices.push_back(0); md.indices.push_back(1); md.indices.push_back(3);
-    md.indices.push_back(0); md.indices.push_back(3); md.indices.push_back(2);
-
-    lightTrailObjData = std::make_shared<ObjData3D>();
-    if (!lightTrailObjData->addMesh(md))
+    lightTrailObjData = std::make_shared<ObjData2D>();
+    lightTrailObjData->usePackedVertices();
+    lightTrailMesh = lightTrailObjData->addMesh(std::move(md));
+    if (lightTrailMesh == INVALID_MESH_HANDLE)
     {
         // fali
         printf("Failed to create light trail obj data\n");
     }
-    lightTrailObj = std::make_unique<Object>(lightTrailObjData, world, shader, glm::mat4(1.0f), colour);
+    lightTrailMeshData = lightTrailObjData->getMeshData(lightTrailMesh);
+}
+
+static void simplifyChunkPath(const MeshData<glm::vec2> &md, float maxError, MeshData<glm::vec2> &simplified)
+{
+    // corners are the same point twice with different normals, so the walls either
+    // side of them look flat. simplify the path with each corner as one point,
+    // and put both halves back for the corners that are left
+    std::vector<glm::vec2> points;
+    std::vector<unsigned int> firstVertices;
+    unsigned int numVertices = md.vertices.size();
+    for (unsigned int i = 0; i < numVertices; i++)
+    {
+        if (i == 0 || md.vertices[i] != md.vertices[i - 1])
+        {
+            points.push_back(md.vertices[i]);
+            firstVertices.push_back(i);
+        }
+    }
+    firstVertices.push_back(numVertices);
+
+    std::vector<bool> keep(points.size(), false);
+    keep.front() = true;
+    simplifyPath(points, 0, points.size() - 1, maxError,
+                 [&](unsigned int i) { keep[i] = true; });
+
+    simplified.name = md.name;
+    simplified.hasTexture = false;
+    simplified.vertices.clear();
+    simplified.normals.clear();
+    for (unsigned int i = 0; i < points.size(); i++)
+    {
+        if (keep[i])
+        {
+            simplified.vertices.insert(simplified.vertices.end(), md.vertices.begin() + firstVertices[i], md.vertices.begin() + firstVertices[i + 1]);
+            simplified.normals.insert(simplified.normals.end(), md.normals.begin() + firstVertices[i], md.normals.begin() + firstVertices[i + 1]);
+        }
+    }
+}
+
+void LightTrail::sealChunk()
+{
+    MeshData<glm::vec2> &md = *lightTrailMeshData;
+
+    // update() can still change the last 2 points, and stopTurning() reads the
+    // normal of the one before them, so those 3 stay in the mesh and the rest get sealed.
+    // the last point we seal is the first one we keep, so the walls join up
+    unsigned int numPoints = md.vertices.size();
+    unsigned int firstKept = numPoints - 3;
+    unsigned int firstChangeable = numPoints - 2;
+
+    MeshData<glm::vec2> &sealed = chunkLevels[0];
+    sealed.name = md.name;
+    sealed.hasTexture = false;
+    sealed.vertices.assign(md.vertices.begin(), md.vertices.begin() + firstChangeable);
+    sealed.normals.assign(md.normals.begin(), md.normals.begin() + firstChangeable);
+
+    md.vertices.erase(md.vertices.begin(), md.vertices.begin() + firstKept);
+    md.normals.erase(md.normals.begin(), md.normals.begin() + firstKept);
+    lightTrailObjData->markDirty(lightTrailMesh, 0, md.vertices.size(), 0, 0);
+
+    LightTrailChunk chunk;
+    if (spareChunks.size())
+    {
+        chunk = std::move(spareChunks.back());
+        spareChunks.pop_back();
+        chunk.maxErrors.clear();
+    }
+    else
+    {
+        chunk.objData = std::make_shared<ObjData2D>();
+        chunk.objData->usePackedVertices();
+    }
+
+    // simplified versions for drawing it when it's further away.
+    // each one is made from the full path, so the errors don't add up
+    unsigned int numLevels = 1;
+    chunk.maxErrors.push_back(0.0f);
+    float maxError = LIGHT_TRAIL_LOD_FIRST_ERROR;
+    for (unsigned int i = 1; i < LIGHT_TRAIL_LOD_LEVELS; i++, maxError *= LIGHT_TRAIL_LOD_ERROR_STEP)
+    {
+        simplifyChunkPath(sealed, maxError, chunkLevels[numLevels]);
+        // not worth keeping if it didn't get any simpler
+        if (chunkLevels[numLevels].vertices.size() < chunkLevels[numLevels - 1].vertices.size())
+        {
+            chunk.maxErrors.push_back(maxError);
+            numLevels++;
+        }
+    }
+
+    // reuse the meshes a spare chunk already has, and add or delete any more or less we need
+    ObjData2D &objData = *chunk.objData;
+    for (unsigned int i = 0; i < numLevels; i++)
+    {
+        if (i < objData.getMeshes().size())
+        {
+            MeshHandle handle = objData.getMeshHandle(i);
+            MeshData<glm::vec2> *level = objData.getMeshData(handle);
+            level->vertices.swap(chunkLevels[i].vertices);
+            level->normals.swap(chunkLevels[i].normals);
+            objData.markDirty(handle, 0, level->vertices.size(), 0, 0);
+        }
+        else if (objData.addMesh(chunkLevels[i]) == INVALID_MESH_HANDLE)
+        {
+            printf("Failed to create light trail chunk\n");
+            if (i == 0)
+            {
+                return;
+            }
+            // just go without this one and the simpler ones
+            numLevels = i;
+            chunk.maxErrors.resize(numLevels);
+        }
+    }
+    while (objData.getMeshes().size() > numLevels)
+    {
+        objData.deleteMesh(objData.getMeshHandle(objData.getMeshes().size() - 1));
+    }
+    objData.updateBuffers();
+
+    // the 2D box is in x and z, the walls go from 0 up to lightTrailHeight
+    BoundingBox<glm::vec2> pathBox = chunk.objData->getBoundingBox();
+    glm::vec2 min = pathBox.vertices[0];
+    glm::vec2 max = pathBox.vertices[2];
+    for (unsigned int i = 0; i < 8; i++)
+    {
+        chunk.boundingBox.vertices[i] = glm::vec3((i & 1) ? max.x : min.x,
+                                                  (i & 2) ? lightTrailHeight : 0.0f,
+                                                  (i & 4) ? max.y : min.y);
+    }
+    sealedChunks.push_back(std::move(chunk));
 }
 
 LightTrail::State LightTrail::calculateState(TurnDirection turning, Accelerating accelerating) const
@@ -104,141 +302,84 @@ LightTrail::State LightTrail::calculateState(TurnDirection turning, Accelerating
     return result;
 }
 
-void LightTrail::turn(float currentAngleRads, bool justStarted)
+void LightTrail::turn(unsigned int currentHeading, bool justStarted)
 {
-    // because the bike has turned, we need to add a new face
-    // to our light trail data.
+    // because the bike has turned, we need to add a new point
+    // to our light trail path, so the shader adds a new face
 
-    MeshData<glm::vec3> &md = lightTrailMeshData;
+    MeshData<glm::vec2> &md = *lightTrailMeshData;
 
-    unsigned int numVertices = md.vertices.size();
-    glm::vec3 lastVertexPosBottom = md.vertices[numVertices - 2];
-    glm::vec3 lastVertexPosTop = md.vertices[numVertices - 1];
+    unsigned int numPoints = md.vertices.size();
+    glm::vec2 lastPoint = md.vertices[numPoints - 1];
     // wall is alwasy verticle, we know which way the bike is facing
     // so normal is 90 degrees (rotated around y) from bike direction
-    // and since the bike is orientated along Z, we can just rotate a unit vector along x by bikeAngle
-    glm::vec3 newNormal = glm::normalize(glm::vec3(glm::vec4(1,0,0,1) * glm::rotate(currentAngleRads, glm::vec3(0,-1,0))));
+    // which is just the bike's right hand side
+    glm::vec2 newNormal = glm::vec2(Heading::cos(currentHeading), Heading::sin(currentHeading));
 
     // if we just started turning we don't want the past long wall
-    // to look curved, ie. don't average normals for the corner vertex
-    // so we need to duplicate the last two vertices (corner vertices),
-    // and amend the normals
+    // to look curved, ie. don't average normals for the corner point
+    // so we need to duplicate the last point (corner point),
+    // and amend the normal
 
     if (justStarted)
     {
-        // duplicate positions and uvs
-        md.vertices.push_back(lastVertexPosBottom);
-        md.vertices.push_back(lastVertexPosTop);
-
-        /*md.uvs.push_back(md.uvs[numVertices - 2]);
-        md.uvs.push_back(md.uvs[numVertices - 1]);*/
-
-        // create new normals
+        md.vertices.push_back(lastPoint);
         md.normals.push_back(newNormal);
-        md.normals.push_back(newNormal);
-
-        numVertices += 2;
     }
     else
     {
         // haven't just started turning, so we share our normals
         // to make a smooth curve
-        glm::vec3 averagedNormal = glm::normalize(newNormal + md.normals[numVertices - 2]);
-        md.normals[numVertices - 2] = averagedNormal;
-        md.normals[numVertices - 1] = averagedNormal;
+        md.normals[numPoints - 1] = glm::normalize(newNormal + md.normals[numPoints - 1]);
     }
 
-    // now we need to add the two new vertices for this face
-    // which means two more vertices, two more normals and 6 more indices
-
-    // currently in same location as previous vertices
-    md.vertices.push_back(md.vertices[numVertices - 2]);
-    md.vertices.push_back(md.vertices[numVertices - 1]);
-
-    // TODO: do UVs properly
-    /*md.uvs.push_back(glm::vec2(0.0f, 0.0f));
-    md.uvs.push_back(glm::vec2(0.0f, 0.0f));*/
-
-    md.normals.push_back(newNormal);
+    // now we need to add the point at the end of this face
+    // currently in same location as previous point
+    md.vertices.push_back(lastPoint);
     md.normals.push_back(newNormal);
-
-    numVertices += 2;
-    md.indices.push_back(numVertices - 4); md.indices.push_back(numVertices - 3); md.indices.push_back(numVertices - 1);
-    md.indices.push_back(numVertices - 4); md.indices.push_back(numVertices - 1); md.indices.push_back(numVertices - 2);
 }
 
 void LightTrail::stopTurning()
 {
-    MeshData<glm::vec3> &md = lightTrailMeshData;
+    MeshData<glm::vec2> &md = *lightTrailMeshData;
 
     // just stopped turning, so to render this as flat
-    // we need to create two extra vertices for the corner
-    // with unique normals
+    // we need to create an extra point for the corner
+    // with a unique normal
 
-    unsigned int numVertices = md.vertices.size();
+    unsigned int numPoints = md.vertices.size();
 
-    // duplicate positions
-    glm::vec3 lastTopPos = md.vertices.back();
-    md.vertices.pop_back();
-    glm::vec3 lastBottomPos = md.vertices.back();
+    // duplicate position
+    glm::vec2 lastPoint = md.vertices.back();
     md.vertices.pop_back();
-
-    md.vertices.push_back(md.vertices[numVertices - 4]);
-    md.vertices.push_back(md.vertices[numVertices - 3]);
-    md.vertices.push_back(lastBottomPos);
-    md.vertices.push_back(lastTopPos);
-
-    // duplicate UVs
-    /*glm::vec2 lastTopUV = md.uvs.back();
-    md.uvs.pop_back();
-    glm::vec2 lastBottomUV = md.uvs.back();
-    md.uvs.pop_back();
-
-    md.uvs.push_back(md.uvs[numVertices - 4]);
-    md.uvs.push_back(md.uvs[numVertices - 3]);
-    md.uvs.push_back(lastBottomUV);
-    md.uvs.push_back(lastTopUV);*/
+    md.vertices.push_back(md.vertices[numPoints - 2]);
+    md.vertices.push_back(lastPoint);
 
     // update normals
-    // the last set of normals are normal to the plane
-    // we just need to create those extra two vertices
-    md.normals.push_back(md.normals[numVertices - 2]);
-    md.normals.push_back(md.normals[numVertices - 1]);
-    // the two normals before that were averaged with this last face
-    // which we don't want anymore, calculate the new normals
-    glm::vec3 newNormal = glm::normalize(glm::cross(md.normals[numVertices - 6] - md.normals[numVertices - 4],
-                                         glm::vec3(0,1,0)));
-    md.normals[numVertices - 4] = newNormal;
-    md.normals[numVertices - 3] = newNormal;
-
-    // update indices
-    numVertices += 2;
-    for (unsigned int i = 0; i < 6; i++)
-    {
-        md.indices.pop_back();
-    }
-    md.indices.push_back(numVertices - 4); md.indices.push_back(numVertices - 3); md.indices.push_back(numVertices - 1);
-    md.indices.push_back(numVertices - 4); md.indices.push_back(numVertices - 1); md.indices.push_back(numVertices - 2);
+    // the last normal is normal to the plane
+    // we just need to create that extra point
+    md.normals.push_back(md.normals[numPoints - 1]);
+    // the normal before that was averaged with this last face
+    // which we don't want anymore, calculate the new normal.
+    // rotating the change in normal 90 degrees around y gives the direction of the face before
+    glm::vec2 normalChange = md.normals[numPoints - 3] - md.normals[numPoints - 2];
+    md.normals[numPoints - 2] = glm::normalize(glm::vec2(-normalChange.y, normalChange.x));
 }
 
 void LightTrail::updateLastVertices(glm::vec3 currentLocation)
 {
-    MeshData<glm::vec3> &md = lightTrailMeshData;
-    // update the positions of the last two vertices
-    md.vertices.pop_back();
-    md.vertices.pop_back();
-    md.vertices.push_back(glm::vec3(currentLocation.x, 0.0f, currentLocation.z));
-    md.vertices.push_back(glm::vec3(currentLocation.x, lightTrailHeight, currentLocation.z));
+    // update the position of the last point
+    lightTrailMeshData->vertices.back() = glm::vec2(currentLocation.x, currentLocation.z);
 }
 
-void LightTrail::createNewPathSegment(float speed, glm::vec3 currentLocation, float currentAngleRads)
+void LightTrail::createNewPathSegment(float speed, glm::vec3 currentLocation, unsigned int currentHeading)
 {
-    std::unique_ptr<LightTrailSegment> uptr;
+    LightTrailSegmentHandle handle;
     switch (state)
     {
         case STATE_STRAIGHT:
         {
-            uptr = std::make_unique<LightTrailSegmentStraight>(glm::vec2(currentLocation.x, currentLocation.z), currentAngleRads, world, shader);
+            handle = segmentStore->add(LightTrailSegmentStraight(glm::vec2(currentLocation.x, currentLocation.z)));
             break;
         }
         case STATE_CIRCLE_LEFT:
@@ -265,38 +406,30 @@ void LightTrail::createNewPathSegment(float speed, glm::vec3 currentLocation, fl
             //  length of (3) = S/2
             //  (1) + (2) + (3) = radius
 
-            float radius = speed / glm::radians(ANGLE_OF_TURNS);
+            // speed is in model units, so scale it to get the radius in world units
+            float radius = worldScale * speed / glm::radians(ANGLE_OF_TURNS);
 
             // now to find the centre
-            // currentAngle = 0 degrees means we are going straight along -ve Z
+            // heading 0 means we are going straight along -ve Z
             // so if we turn right our centre is directly to the right of us
             // if we turn left, then it's to our left.
-            glm::vec3 radiusVector = glm::vec3(glm::vec4((state == STATE_CIRCLE_RIGHT) ? radius : -radius, 0, 0, 1) *
-                                               glm::rotate(currentAngleRads, glm::vec3(0,1,0)));
+            glm::vec2 right = Heading::right(currentHeading);
+            glm::vec3 radiusVector = ((state == STATE_CIRCLE_RIGHT) ? radius : -radius) * glm::vec3(right.x, 0, right.y);
             glm::vec3 centre = currentLocation + radiusVector;
 
             // finally calculate startAngle
             // this is the angle between th ebike and the centre point with respect to -ve Z
             // ie. straight forward.
-            // this is pretty simple, it's 90 degrees offset from currentAngle
-            // if we turn right we are -90 degrees, and for left +90 degrees
-            float startAngle = currentAngleRads + glm::radians((state == STATE_CIRCLE_RIGHT) ? -90.0f : 90.0f);
-            // startAngle should be between 0 and 2PI
-            while (startAngle >= 2*glm::pi<float>())
-            {
-                startAngle -= 2*glm::pi<float>();
-            }
-            while (startAngle < 0)
-            {
-                startAngle += 2*glm::pi<float>();
-            }
-
-            uptr = std::make_unique<LightTrailSegmentCircle>(glm::vec2(centre.x, centre.z),
-                                                             radius,
-                                                             startAngle,
-                                                             (state == STATE_CIRCLE_RIGHT) ? TURN_RIGHT : TURN_LEFT,
-                                                             world,
-                                                             shader);
+            // this is pretty simple, it's 90 degrees offset from our heading
+            // if we turn right we are -90 degrees (a quarter of the headings), and for left +90 degrees
+            unsigned int startHeading = (state == STATE_CIRCLE_RIGHT) ? currentHeading + NUM_HEADINGS - (NUM_HEADINGS / 4) :
+                                                                        currentHeading + (NUM_HEADINGS / 4);
+            startHeading %= NUM_HEADINGS;
+
+            handle = segmentStore->add(LightTrailSegmentCircle(glm::vec2(centre.x, centre.z),
+                                                               radius,
+                                                               startHeading,
+                                                               (state == STATE_CIRCLE_RIGHT) ? TURN_RIGHT : TURN_LEFT));
             break;
         }
         case STATE_SPIRAL_OUT_LEFT:
@@ -308,51 +441,96 @@ void LightTrail::createNewPathSegment(float speed, glm::vec3 currentLocation, fl
                                 state == STATE_SPIRAL_IN_LEFT) ? TURN_LEFT : TURN_RIGHT;
             Accelerating accel = (state == STATE_SPIRAL_OUT_LEFT ||
                                   state == STATE_SPIRAL_OUT_RIGHT) ? SPEED_ACCELERATE : SPEED_BRAKE;
-            uptr = std::make_unique<LightTrailSegmentSpiral>(glm::vec2(currentLocation.x, currentLocation.z), speed, currentAngleRads, td, accel, world, shader);
+            handle = segmentStore->add(LightTrailSegmentSpiral(glm::vec2(currentLocation.x, currentLocation.z), speed, currentHeading, td, accel, worldScale));
             break;
         }
     }
-    pathSegments.push_back(std::move(uptr));
+    // the segment we were on is finished now
+    if (pathSegments.size())
+    {
+        selfGrid->insert(pathSegments.back());
+    }
+
+    grid->insert(handle);
+    pathSegments.push_back(handle);
+}
+
+void LightTrail::compactPathSegments()
+{
+    // leave the segment the bike is on alone, it's still changing
+    for (unsigned int i = 0; i < LIGHT_TRAIL_COMPACTION_STEPS; i++)
+    {
+        if (numCompactedSegments + 2 >= pathSegments.size())
+        {
+            return;
+        }
+
+        LightTrailSegmentHandle first = pathSegments[numCompactedSegments];
+        LightTrailSegmentHandle second = pathSegments[numCompactedSegments + 1];
+        LightTrailSegmentHandle combined;
+        if (segmentStore->combine(first, second, compactionMaxError, combined))
+        {
+            // try adding the next one on to it next time
+            grid->remove(first);
+            grid->remove(second);
+            grid->insert(combined);
+            selfGrid->remove(first);
+            selfGrid->remove(second);
+            selfGrid->insert(combined);
+            pathSegments[numCompactedSegments] = combined;
+            pathSegments.erase(pathSegments.begin() + numCompactedSegments + 1);
+        }
+        else
+        {
+            numCompactedSegments++;
+        }
+    }
 }
 
-void LightTrail::update(TurnDirection turning, Accelerating accelerating, float speed, glm::vec3 currentLocation, float currentAngleRads)
+void LightTrail::update(TurnDirection turning, Accelerating accelerating, float speed, glm::vec3 currentLocation, unsigned int currentHeading)
 {
     // are we stopping? if so fade down until we are dead
     if (stopping)
     {
 #ifndef DEBUG_STOP_TRAILS_FADING
-        bool changedSomething = false;
-        for (auto &v : lightTrailMeshData.vertices)
+        // the shader builds the walls up to height, see draw(). every chunk fades
+        // together, so none of them can go before the trail is dead, and then
+        // the manager reset()s us and they're kept for the next trail to use
+        if (lightTrailObjData && height > 0.05f)
         {
-            if (v.y > 0.05f)
-            {
-                v.y -= 0.05f;
-                changedSomething = true;
-            }
+            height -= 0.05f;
         }
-        if (!changedSomething)
+        else
         {
+            // we've faded away, so nothing can collide with us anymore
             isStopped = true;
+            removeFromGrid();
         }
-
-        // nothing more to do, as we are stopping
-        lightTrailObjData->updateMesh(lightTrailMeshData);
-        lightTrailObjData->updateBuffers();
 #endif
         return;
     }
 
     // check if we have an object and object data ptrs
-    // if not create them and the initial face
-    if (!lightTrailObjData || !lightTrailObj)
+    // if not (or we've been reset) create them and the initial face
+    if (!lightTrailObjData || lightTrailMeshData->vertices.empty())
+    {
+        createObject(currentLocation, currentHeading);
+    }
+    else if (lightTrailMeshData->vertices.size() >= LIGHT_TRAIL_CHUNK_POINTS)
     {
-        createObject(currentLocation, currentAngleRads);
+        sealChunk();
     }
 
+    // turning, stopping turning and moving the end of the trail only ever change
+    // the last 2 points (stopTurning() goes back the furthest)
+    unsigned int numPoints = lightTrailMeshData->vertices.size();
+    unsigned int firstChangedPoint = (numPoints > 2) ? numPoints - 2 : 0;
+
     // create initial path segment if needed
     if (pathSegments.size() == 0)
     {
-        createNewPathSegment(speed, currentLocation, currentAngleRads);
+        createNewPathSegment(speed, currentLocation, currentHeading);
+        lastLocation = glm::vec2(currentLocation.x, currentLocation.z);
     }
 
     // deal with turning
@@ -360,7 +538,7 @@ void LightTrail::update(TurnDirection turning, Accelerating accelerating, float
     // so that our curves are smooth
     if (turning != NO_TURN)
     {
-        turn(currentAngleRads, (state == STATE_STRAIGHT));
+        turn(currentHeading, (state == STATE_STRAIGHT));
     }
     else if (state != STATE_STRAIGHT)
     {
@@ -374,52 +552,105 @@ void LightTrail::update(TurnDirection turning, Accelerating accelerating, float
     State newState = calculateState(turning, accelerating);
 
     // update current path segment
-    pathSegments.back()->update(glm::vec2(currentLocation.x, currentLocation.z), currentAngleRads);
+    glm::vec2 location(currentLocation.x, currentLocation.z);
+    segmentStore->update(pathSegments.back(), location, currentHeading);
+    grid->update(pathSegments.back());
+
+    // has the bit of trail we just added crossed any of the rest of our trail?
+    float timeOfImpact;
+    selfCollided = selfGrid->collides(glm::mix(lastLocation, location, LIGHT_TRAIL_SELF_COLLISION_SKIP), location, timeOfImpact);
+    lastLocation = location;
 
     if (state != newState)
     {
         state = newState;
-        createNewPathSegment(speed, currentLocation, currentAngleRads);
+        createNewPathSegment(speed, currentLocation, currentHeading);
     }
 
-    lightTrailObjData->updateMesh(lightTrailMeshData);
+    compactPathSegments();
+
+    lightTrailObjData->markDirty(lightTrailMesh, firstChangedPoint, lightTrailMeshData->vertices.size(), 0, 0);
     lightTrailObjData->updateBuffers();
 }
 
-bool LightTrail::collides(const glm::vec2 &location) const
+bool LightTrail::checkSelfCollision() const
 {
-    for (auto &ps : pathSegments)
+    if (selfCollided)
     {
-        if (ps->collides(location))
-        {
-            return true;
-        }
+        return true;
+    }
+
+    // the segment we are on can't be in selfGrid, as it's always
+    // touching where we are, so it checks itself
+    if (pathSegments.size())
+    {
+        return segmentStore->checkSelfCollision(pathSegments.back());
     }
     return false;
 }
 
-bool LightTrail::checkSelfCollision() const
+void LightTrail::drawPath(const std::shared_ptr<Mesh<glm::vec2>> &mesh) const
 {
-    if (pathSegments.size())
+    // the path is packed, see ObjData::usePackedVertices(), the shader unpacks the positions with these
+    shader->setUniform(SHADER_UNIFORM_POSITION_ORIGIN, mesh->positionOrigin);
+    shader->setUniform(SHADER_UNIFORM_POSITION_SCALE, mesh->positionScale);
+
+    // each line between two points becomes a face
+    mesh->bindVertexArray(*shader);
+    glDrawArrays(GL_LINE_STRIP, 0, mesh->numVertices);
+}
+
+unsigned int LightTrail::chooseLevelOfDetail(const LightTrailChunk &chunk, const glm::vec3 &cameraPosition) const
+{
+    // go by the nearest bit of the chunk to the camera
+    glm::vec3 min = chunk.boundingBox.vertices[0];
+    glm::vec3 max = chunk.boundingBox.vertices[0];
+    for (auto &v : chunk.boundingBox.vertices)
     {
-        return pathSegments.back()->checkSelfCollision();
+        min = glm::min(min, v);
+        max = glm::max(max, v);
     }
-    return false;
+    float distance = glm::distance(cameraPosition, glm::clamp(cameraPosition, min, max));
+    float allowedError = LIGHT_TRAIL_LOD_MAX_SCREEN_ERROR * world->getScreenHeightAt(distance);
+
+    unsigned int level = 0;
+    while (level + 1 < chunk.maxErrors.size() && chunk.maxErrors[level + 1] <= allowedError)
+    {
+        level++;
+    }
+    return level;
 }
 
 void LightTrail::draw() const
 {
 #ifndef DEBUG_HIDE_NORMAL_LIGHT_TRAIL
-    if (lightTrailObj)
+    // nothing to draw if we've been reset and not updated since
+    if (lightTrailObjData && lightTrailMeshData->vertices.size())
     {
-        lightTrailObj->drawAll();
+        shader->useShader();
+
+        // light trails are already in world co-ords
+        world->sendMVP(shader, glm::mat4(1.0f));
+        shader->setUniform(SHADER_UNIFORM_WALL_HEIGHT, height);
+        shader->setUniform(SHADER_UNIFORM_FRAGMENT_COLOUR, colour);
+        shader->setUniform(SHADER_UNIFORM_IS_TEXTURE, 0.0f);
+
+        glm::vec3 cameraPosition = world->getCameraPosition();
+        for (auto &chunk : sealedChunks)
+        {
+            if (world->isVisible(chunk.boundingBox))
+            {
+                drawPath(chunk.objData->getMeshes()[chooseLevelOfDetail(chunk, cameraPosition)]);
+            }
+        }
+        drawPath(lightTrailObjData->getMeshes()[0]);
     }
 #endif
 #ifdef DEBUG_SHOW_LIGHT_TRAIL_SEGMENTS
     std::for_each(pathSegments.begin(), pathSegments.end(),
-                  [](const std::unique_ptr<LightTrailSegment> &segment)
+                  [this](LightTrailSegmentHandle segment)
     {
-        segment->drawDebugMesh();
+        segmentStore->drawDebugMesh(segment);
     });
 #endif
-}
\ No newline at end of file
+}
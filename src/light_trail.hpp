@@ -2,6 +2,7 @@
 #define __LIGHT_TRAIL_HPP
 
 #include "bike_movements.hpp"
+#include "light_trail_segment.hpp"
 #include "object_data.hpp"
 
 #include <memory>
@@ -11,20 +12,40 @@
 
 class World;
 class Shader;
-class Object;
-class LightTrailSegment;
+class LightTrailSegmentStore;
+class LightTrailGrid;
+
+// part of a light trail's path that can't change anymore,
+// so it lives in a static buffer
+struct LightTrailChunk
+{
+    // meshes[i] is the path simplified so no point is more than
+    // maxErrors[i] away from it. meshes[0] is the whole path
+    std::shared_ptr<ObjData2D> objData;
+    std::vector<float> maxErrors;           // in world units
+    BoundingBox<glm::vec3> boundingBox;     // of the walls
+};
 
 class LightTrail
 {
 public:
     LightTrail(std::shared_ptr<World> _world,
                std::shared_ptr<const Shader> _shader,
+               std::shared_ptr<LightTrailSegmentStore> _segmentStore,
+               std::shared_ptr<LightTrailGrid> _grid,
                glm::vec3 _colour,
+               float _worldScale,
+               float _compactionMaxError,
                TurnDirection turning,
                Accelerating accelerating);
     ~LightTrail();
 
-    void update(TurnDirection turning, Accelerating accelerating, float speed, glm::vec3 currentLocation, float currentAngleRads);
+    // let go of the trail we had, but keep its buffers and memory,
+    // so we can be reused for a new trail with start()
+    void reset();
+    void start(TurnDirection turning, Accelerating accelerating);
+
+    void update(TurnDirection turning, Accelerating accelerating, float speed, glm::vec3 currentLocation, unsigned int currentHeading);
 
     // start fading down the trail
     void stop() { stopping = true; }
@@ -33,7 +54,7 @@ public:
     // if so we can delete it
     bool isDead() const { return isStopped; }
 
-    bool collides(const glm::vec2 &location) const;
+    // have we crashed into our own trail
     bool checkSelfCollision() const;
 
     void draw() const;
@@ -50,24 +71,55 @@ protected:
         STATE_SPIRAL_IN_RIGHT,
     };
 
-    void createObject(glm::vec3 currentLocation, float currentAngleRads);
+    void createObject(glm::vec3 currentLocation, unsigned int currentHeading);
     State calculateState(TurnDirection turning, Accelerating accelerating) const;
-    void LightTrail::turn(float currentAngleRads, bool justStarted);
+    void LightTrail::turn(unsigned int currentHeading, bool justStarted);
     void LightTrail::stopTurning();
     void LightTrail::updateLastVertices(glm::vec3 currentLocation);
-    void createNewPathSegment(float speed, glm::vec3 currentLocation, float currentAngleRads);
+    void sealChunk();
+    unsigned int chooseLevelOfDetail(const LightTrailChunk &chunk, const glm::vec3 &cameraPosition) const;
+    void drawPath(const std::shared_ptr<Mesh<glm::vec2>> &mesh) const;
+    void createNewPathSegment(float speed, glm::vec3 currentLocation, unsigned int currentHeading);
+    void compactPathSegments();
+    void removeFromGrid();
 
     std::shared_ptr<World> world;
     std::shared_ptr<const Shader> shader;
+    std::shared_ptr<LightTrailSegmentStore> segmentStore;
+    std::shared_ptr<LightTrailGrid> grid;
     glm::vec3 colour;
-
-    // meshes for drawing to the screen
-    MeshData<glm::vec3> lightTrailMeshData;
-    std::shared_ptr<ObjData3D> lightTrailObjData;
-    std::unique_ptr<Object> lightTrailObj;
+    float worldScale;   // world units per unit of bike speed
+
+    // meshes for drawing to the screen. we only store the path along the bottom of the
+    // walls (x and z of each point, with the wall's normal there) and the shader builds the walls.
+    // we edit the mesh data in lightTrailObjData directly, rather than copying it in every update
+    MeshHandle lightTrailMesh;
+    MeshData<glm::vec2> *lightTrailMeshData;
+    std::shared_ptr<ObjData2D> lightTrailObjData;
+    // once lightTrailObjData gets big enough all but the end of it is moved into
+    // a sealed chunk, so each update only touches the newest bit of the trail
+    std::vector<LightTrailChunk> sealedChunks;
+    // chunks from before we were reset, to reuse the buffers of
+    std::vector<LightTrailChunk> spareChunks;
+    // the path of the chunk we're sealing and the simplified versions of it. they get
+    // swapped with the chunk's mesh data, so their memory gets passed around rather than reallocated
+    std::vector<MeshData<glm::vec2>> chunkLevels;
+    float height;   // of the walls, goes down as we fade
 
     // abstract path info for collision detection
-    std::vector<std::unique_ptr<LightTrailSegment>> pathSegments;
+    // the segments live in the segment store, and are also
+    // added to the grid, which is what we query
+    std::vector<LightTrailSegmentHandle> pathSegments;
+    // just our finished segments (not the one the bike is on), so we can
+    // check the bit of trail we add each frame against the rest of our trail
+    std::unique_ptr<LightTrailGrid> selfGrid;
+    glm::vec2 lastLocation;
+    bool selfCollided;
+
+    // finished segments get combined a few at a time, to make them quicker
+    // to check against. the ones before this have been done
+    unsigned int numCompactedSegments;
+    float compactionMaxError;   // in world units
 
     State state;
     bool stopping;
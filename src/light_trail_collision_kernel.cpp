@@ -0,0 +1,349 @@
+#include "light_trail_collision_kernel.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#ifdef LIGHT_TRAIL_COLLISION_USE_SSE
+#include <emmintrin.h>
+#endif
+
+// probes that have moved less than this (squared) haven't moved
+#define NOT_MOVED_EPSILON   0.000001f
+// straight walls are parallel to a probe if the sine of the angle between them is
+// below this. it has to cover the rounding in points hundreds of units from the
+// origin, which gets to ~0.0002 for a probe that's only moved 0.05, and the smallest
+// real angle is ANGLE_OF_TURNS (a sine of ~0.035)
+#define PARALLEL_SINE_EPSILON   0.01f
+// allow hitting a wall right on its end point, so we can't slip between
+// two walls that join, eg. the lines making up a spiral
+#define END_POINT_EPSILON   0.0001f
+
+// PROBES AND BATCHES =========================================================
+
+void LightTrailProbes::clear()
+{
+    fromX.clear();
+    fromZ.clear();
+    toX.clear();
+    toZ.clear();
+}
+
+void LightTrailProbes::add(const glm::vec2 &from, const glm::vec2 &to)
+{
+    fromX.push_back(from.x);
+    fromZ.push_back(from.y);
+    toX.push_back(to.x);
+    toZ.push_back(to.y);
+}
+
+void LightTrailStraightBatch::clear()
+{
+    startX.clear();
+    startZ.clear();
+    endX.clear();
+    endZ.clear();
+}
+
+void LightTrailStraightBatch::add(const glm::vec2 &start, const glm::vec2 &end)
+{
+    startX.push_back(start.x);
+    startZ.push_back(start.y);
+    endX.push_back(end.x);
+    endZ.push_back(end.y);
+}
+
+void LightTrailArcBatch::clear()
+{
+    centreX.clear();
+    centreZ.clear();
+    radiusSquared.clear();
+    startDirectionX.clear();
+    startDirectionZ.clear();
+    stopDirectionX.clear();
+    stopDirectionZ.clear();
+    turnSign.clear();
+    moreThanHalf.clear();
+}
+
+void LightTrailArcBatch::add(const glm::vec2 &centre, float radius,
+                             const glm::vec2 &startDirection, const glm::vec2 &stopDirection,
+                             float _turnSign, bool _moreThanHalf)
+{
+    centreX.push_back(centre.x);
+    centreZ.push_back(centre.y);
+    radiusSquared.push_back(radius * radius);
+    startDirectionX.push_back(startDirection.x);
+    startDirectionZ.push_back(startDirection.y);
+    stopDirectionX.push_back(stopDirection.x);
+    stopDirectionZ.push_back(stopDirection.y);
+    turnSign.push_back(_turnSign);
+    moreThanHalf.push_back(_moreThanHalf ? 1.0f : 0.0f);
+}
+
+// SCALAR =====================================================================
+
+float collideStraight(const glm::vec2 &from, const glm::vec2 &to,
+                      const glm::vec2 &start, const glm::vec2 &end)
+{
+    // from + t(to - from) = start + u(end - start)
+    // cross both sides with (end - start) to get t, and with (to - from) to get u
+    glm::vec2 r = to - from;
+    glm::vec2 s = end - start;
+    glm::vec2 ab = start - from;
+
+    // |r x s| = |r||s|sin, so compare the squares to avoid the square roots
+    float denominator = (r.x * s.y) - (r.y * s.x);
+    float parallelLimit = (PARALLEL_SINE_EPSILON * PARALLEL_SINE_EPSILON) *
+                          ((r.x * r.x) + (r.y * r.y)) * ((s.x * s.x) + (s.y * s.y));
+    if ((denominator * denominator) <= parallelLimit)
+    {
+        // parallel, or one of the lines has no length.
+        // we ignore the collinear case (where ab x s is ~0 as well, so t
+        // is just rounding), as that's us driving along our own trail.
+        return LIGHT_TRAIL_NO_HIT;
+    }
+
+    float t = ((ab.x * s.y) - (ab.y * s.x)) / denominator;
+    float u = ((ab.x * r.y) - (ab.y * r.x)) / denominator;
+
+    if (t < 0.0f || t > 1.0f ||
+        u < -END_POINT_EPSILON || u > (1.0f + END_POINT_EPSILON))
+    {
+        return LIGHT_TRAIL_NO_HIT;
+    }
+    return t;
+}
+
+float collideArc(const glm::vec2 &from, const glm::vec2 &to,
+                 const glm::vec2 &centre, float radiusSquared,
+                 const glm::vec2 &startDirection, const glm::vec2 &stopDirection,
+                 float turnSign, bool moreThanHalf)
+{
+    // where does the line from + t(to - from) cross the circle
+    // |from + t(to - from) - centre|^2 = radius^2
+    // which gives us a quadratic in t: at^2 + 2bt + c = 0
+    glm::vec2 d = to - from;
+    glm::vec2 f = from - centre;
+
+    float a = glm::dot(d, d);
+    float b = glm::dot(d, f);
+    float c = glm::dot(f, f) - radiusSquared;
+
+    if (a < NOT_MOVED_EPSILON)
+    {
+        // we haven't moved
+        return LIGHT_TRAIL_NO_HIT;
+    }
+
+    float discriminant = (b * b) - (a * c);
+    if (discriminant < 0.0f)
+    {
+        // doesn't touch the circle
+        return LIGHT_TRAIL_NO_HIT;
+    }
+
+    // check both points where we cross the circle, first one first
+    float sqrtDiscriminant = sqrt(discriminant);
+    float roots[2] = { (-b - sqrtDiscriminant) / a,
+                       (-b + sqrtDiscriminant) / a };
+    for (auto t : roots)
+    {
+        if (t < 0.0f || t > 1.0f)
+        {
+            continue;
+        }
+
+        // is the point in the sector swept out by the arc?
+        // ie. is it past the start and before the stop, in the direction we turned
+        glm::vec2 v = f + (t * d);
+        bool pastStart = turnSign * ((startDirection.x * v.y) - (startDirection.y * v.x)) >= 0.0f;
+        bool beforeStop = turnSign * ((v.x * stopDirection.y) - (v.y * stopDirection.x)) >= 0.0f;
+
+        // if the arc is more than half a circle, we only miss it
+        // if we are in the gap, which is less than half a circle
+        if (moreThanHalf ? (pastStart || beforeStop) : (pastStart && beforeStop))
+        {
+            return t;
+        }
+    }
+    return LIGHT_TRAIL_NO_HIT;
+}
+
+// BATCHED ====================================================================
+
+void collideStraights(const LightTrailProbes &probes, const LightTrailStraightBatch &straights, float *timeOfImpact)
+{
+    unsigned int numProbes = probes.size();
+    unsigned int numStraights = straights.size();
+    unsigned int i = 0;
+
+#ifdef LIGHT_TRAIL_COLLISION_USE_SSE
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 noHit = _mm_set1_ps(LIGHT_TRAIL_NO_HIT);
+    const __m128 parallelSineEpsilonSquared = _mm_set1_ps(PARALLEL_SINE_EPSILON * PARALLEL_SINE_EPSILON);
+    const __m128 uMin = _mm_set1_ps(-END_POINT_EPSILON);
+    const __m128 uMax = _mm_set1_ps(1.0f + END_POINT_EPSILON);
+
+    // 4 probes at a time
+    for (; i + 4 <= numProbes; i += 4)
+    {
+        __m128 fromX = _mm_loadu_ps(&probes.fromX[i]);
+        __m128 fromZ = _mm_loadu_ps(&probes.fromZ[i]);
+        __m128 rX = _mm_sub_ps(_mm_loadu_ps(&probes.toX[i]), fromX);
+        __m128 rZ = _mm_sub_ps(_mm_loadu_ps(&probes.toZ[i]), fromZ);
+        __m128 rLengthSquared = _mm_mul_ps(parallelSineEpsilonSquared,
+                                           _mm_add_ps(_mm_mul_ps(rX, rX), _mm_mul_ps(rZ, rZ)));
+        __m128 best = _mm_loadu_ps(&timeOfImpact[i]);
+
+        for (unsigned int j = 0; j < numStraights; j++)
+        {
+            __m128 startX = _mm_set1_ps(straights.startX[j]);
+            __m128 startZ = _mm_set1_ps(straights.startZ[j]);
+            float sx = straights.endX[j] - straights.startX[j];
+            float sz = straights.endZ[j] - straights.startZ[j];
+            __m128 sX = _mm_set1_ps(sx);
+            __m128 sZ = _mm_set1_ps(sz);
+            __m128 sLengthSquared = _mm_set1_ps((sx * sx) + (sz * sz));
+            __m128 abX = _mm_sub_ps(startX, fromX);
+            __m128 abZ = _mm_sub_ps(startZ, fromZ);
+
+            __m128 denominator = _mm_sub_ps(_mm_mul_ps(rX, sZ), _mm_mul_ps(rZ, sX));
+            __m128 t = _mm_div_ps(_mm_sub_ps(_mm_mul_ps(abX, sZ), _mm_mul_ps(abZ, sX)), denominator);
+            __m128 u = _mm_div_ps(_mm_sub_ps(_mm_mul_ps(abX, rZ), _mm_mul_ps(abZ, rX)), denominator);
+
+            // the same parallel test as collideStraight().
+            // lanes that were parallel have garbage in t and u, but they get masked out
+            __m128 hit = _mm_cmpgt_ps(_mm_mul_ps(denominator, denominator),
+                                      _mm_mul_ps(rLengthSquared, sLengthSquared));
+            hit = _mm_and_ps(hit, _mm_cmpge_ps(t, zero));
+            hit = _mm_and_ps(hit, _mm_cmple_ps(t, one));
+            hit = _mm_and_ps(hit, _mm_cmpge_ps(u, uMin));
+            hit = _mm_and_ps(hit, _mm_cmple_ps(u, uMax));
+
+            __m128 result = _mm_or_ps(_mm_and_ps(hit, t), _mm_andnot_ps(hit, noHit));
+            best = _mm_min_ps(best, result);
+        }
+
+        _mm_storeu_ps(&timeOfImpact[i], best);
+    }
+#endif
+
+    // whatever's left over
+    for (; i < numProbes; i++)
+    {
+        glm::vec2 from(probes.fromX[i], probes.fromZ[i]);
+        glm::vec2 to(probes.toX[i], probes.toZ[i]);
+        for (unsigned int j = 0; j < numStraights; j++)
+        {
+            float t = collideStraight(from, to,
+                                      glm::vec2(straights.startX[j], straights.startZ[j]),
+                                      glm::vec2(straights.endX[j], straights.endZ[j]));
+            timeOfImpact[i] = std::min(timeOfImpact[i], t);
+        }
+    }
+}
+
+#ifdef LIGHT_TRAIL_COLLISION_USE_SSE
+// mask of the lanes where the point centre + v is on the arc
+static inline __m128 isOnArc4(__m128 vX, __m128 vZ,
+                              __m128 startDirectionX, __m128 startDirectionZ,
+                              __m128 stopDirectionX, __m128 stopDirectionZ,
+                              __m128 turnSign, bool moreThanHalf)
+{
+    const __m128 zero = _mm_setzero_ps();
+    __m128 pastStart = _mm_cmpge_ps(_mm_mul_ps(turnSign, _mm_sub_ps(_mm_mul_ps(startDirectionX, vZ),
+                                                                    _mm_mul_ps(startDirectionZ, vX))), zero);
+    __m128 beforeStop = _mm_cmpge_ps(_mm_mul_ps(turnSign, _mm_sub_ps(_mm_mul_ps(vX, stopDirectionZ),
+                                                                     _mm_mul_ps(vZ, stopDirectionX))), zero);
+    return moreThanHalf ? _mm_or_ps(pastStart, beforeStop) : _mm_and_ps(pastStart, beforeStop);
+}
+#endif
+
+void collideArcs(const LightTrailProbes &probes, const LightTrailArcBatch &arcs, float *timeOfImpact)
+{
+    unsigned int numProbes = probes.size();
+    unsigned int numArcs = arcs.size();
+    unsigned int i = 0;
+
+#ifdef LIGHT_TRAIL_COLLISION_USE_SSE
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 noHit = _mm_set1_ps(LIGHT_TRAIL_NO_HIT);
+    const __m128 notMovedEpsilon = _mm_set1_ps(NOT_MOVED_EPSILON);
+
+    // 4 probes at a time
+    for (; i + 4 <= numProbes; i += 4)
+    {
+        __m128 fromX = _mm_loadu_ps(&probes.fromX[i]);
+        __m128 fromZ = _mm_loadu_ps(&probes.fromZ[i]);
+        __m128 dX = _mm_sub_ps(_mm_loadu_ps(&probes.toX[i]), fromX);
+        __m128 dZ = _mm_sub_ps(_mm_loadu_ps(&probes.toZ[i]), fromZ);
+        __m128 a = _mm_add_ps(_mm_mul_ps(dX, dX), _mm_mul_ps(dZ, dZ));
+        __m128 moved = _mm_cmpge_ps(a, notMovedEpsilon);
+        __m128 best = _mm_loadu_ps(&timeOfImpact[i]);
+
+        for (unsigned int j = 0; j < numArcs; j++)
+        {
+            __m128 fX = _mm_sub_ps(fromX, _mm_set1_ps(arcs.centreX[j]));
+            __m128 fZ = _mm_sub_ps(fromZ, _mm_set1_ps(arcs.centreZ[j]));
+
+            __m128 b = _mm_add_ps(_mm_mul_ps(dX, fX), _mm_mul_ps(dZ, fZ));
+            __m128 c = _mm_sub_ps(_mm_add_ps(_mm_mul_ps(fX, fX), _mm_mul_ps(fZ, fZ)),
+                                  _mm_set1_ps(arcs.radiusSquared[j]));
+            __m128 discriminant = _mm_sub_ps(_mm_mul_ps(b, b), _mm_mul_ps(a, c));
+            __m128 touches = _mm_and_ps(moved, _mm_cmpge_ps(discriminant, zero));
+
+            __m128 sqrtDiscriminant = _mm_sqrt_ps(_mm_max_ps(discriminant, zero));
+            __m128 t0 = _mm_div_ps(_mm_sub_ps(_mm_sub_ps(zero, b), sqrtDiscriminant), a);
+            __m128 t1 = _mm_div_ps(_mm_add_ps(_mm_sub_ps(zero, b), sqrtDiscriminant), a);
+
+            __m128 startDirectionX = _mm_set1_ps(arcs.startDirectionX[j]);
+            __m128 startDirectionZ = _mm_set1_ps(arcs.startDirectionZ[j]);
+            __m128 stopDirectionX = _mm_set1_ps(arcs.stopDirectionX[j]);
+            __m128 stopDirectionZ = _mm_set1_ps(arcs.stopDirectionZ[j]);
+            __m128 turnSign = _mm_set1_ps(arcs.turnSign[j]);
+            bool moreThanHalf = arcs.moreThanHalf[j] > 0.5f;
+
+            __m128 hit0 = _mm_and_ps(touches, _mm_and_ps(_mm_cmpge_ps(t0, zero), _mm_cmple_ps(t0, one)));
+            hit0 = _mm_and_ps(hit0, isOnArc4(_mm_add_ps(fX, _mm_mul_ps(t0, dX)),
+                                             _mm_add_ps(fZ, _mm_mul_ps(t0, dZ)),
+                                             startDirectionX, startDirectionZ,
+                                             stopDirectionX, stopDirectionZ,
+                                             turnSign, moreThanHalf));
+
+            __m128 hit1 = _mm_and_ps(touches, _mm_and_ps(_mm_cmpge_ps(t1, zero), _mm_cmple_ps(t1, one)));
+            hit1 = _mm_and_ps(hit1, isOnArc4(_mm_add_ps(fX, _mm_mul_ps(t1, dX)),
+                                             _mm_add_ps(fZ, _mm_mul_ps(t1, dZ)),
+                                             startDirectionX, startDirectionZ,
+                                             stopDirectionX, stopDirectionZ,
+                                             turnSign, moreThanHalf));
+
+            // t0 <= t1, so taking the min gives us the first one we hit
+            __m128 result0 = _mm_or_ps(_mm_and_ps(hit0, t0), _mm_andnot_ps(hit0, noHit));
+            __m128 result1 = _mm_or_ps(_mm_and_ps(hit1, t1), _mm_andnot_ps(hit1, noHit));
+            best = _mm_min_ps(best, _mm_min_ps(result0, result1));
+        }
+
+        _mm_storeu_ps(&timeOfImpact[i], best);
+    }
+#endif
+
+    // whatever's left over
+    for (; i < numProbes; i++)
+    {
+        glm::vec2 from(probes.fromX[i], probes.fromZ[i]);
+        glm::vec2 to(probes.toX[i], probes.toZ[i]);
+        for (unsigned int j = 0; j < numArcs; j++)
+        {
+            float t = collideArc(from, to,
+                                 glm::vec2(arcs.centreX[j], arcs.centreZ[j]),
+                                 arcs.radiusSquared[j],
+                                 glm::vec2(arcs.startDirectionX[j], arcs.startDirectionZ[j]),
+                                 glm::vec2(arcs.stopDirectionX[j], arcs.stopDirectionZ[j]),
+                                 arcs.turnSign[j],
+                                 arcs.moreThanHalf[j] > 0.5f);
+            timeOfImpact[i] = std::min(timeOfImpact[i], t);
+        }
+    }
+}
@@ -0,0 +1,82 @@
+#ifndef __LIGHT_TRAIL_COLLISION_KERNEL_HPP
+#define __LIGHT_TRAIL_COLLISION_KERNEL_HPP
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+// SSE2 is always there on x64, and on x86 when building with /arch:SSE2
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#define LIGHT_TRAIL_COLLISION_USE_SSE
+#endif
+
+// time of impact for moves that don't hit anything
+#define LIGHT_TRAIL_NO_HIT  2.0f
+
+// Batch collision tests of lots of moves (probes) against lots of
+// straight and arc light trail walls. Everything is stored as
+// structure of arrays so we can test 4 probes at once against each wall.
+// There's no trig, just dot and cross products and one sqrt per arc test.
+
+// the moves of points on the bikes this frame
+struct LightTrailProbes
+{
+    std::vector<float> fromX;
+    std::vector<float> fromZ;
+    std::vector<float> toX;
+    std::vector<float> toZ;
+
+    void clear();
+    void add(const glm::vec2 &from, const glm::vec2 &to);
+    unsigned int size() const { return fromX.size(); }
+};
+
+struct LightTrailStraightBatch
+{
+    std::vector<float> startX;
+    std::vector<float> startZ;
+    std::vector<float> endX;
+    std::vector<float> endZ;
+
+    void clear();
+    void add(const glm::vec2 &start, const glm::vec2 &end);
+    unsigned int size() const { return startX.size(); }
+};
+
+// arcs of circles, the arc runs from startDirection to stopDirection
+// (relative to the centre) in the direction given by turnSign
+// +1 = angles increasing (turning right), -1 = decreasing (turning left)
+struct LightTrailArcBatch
+{
+    std::vector<float> centreX;
+    std::vector<float> centreZ;
+    std::vector<float> radiusSquared;
+    std::vector<float> startDirectionX;
+    std::vector<float> startDirectionZ;
+    std::vector<float> stopDirectionX;
+    std::vector<float> stopDirectionZ;
+    std::vector<float> turnSign;
+    std::vector<float> moreThanHalf;    // 1 if the arc is over 180 degrees, 0 if not
+
+    void clear();
+    void add(const glm::vec2 &centre, float radius,
+             const glm::vec2 &startDirection, const glm::vec2 &stopDirection,
+             float turnSign, bool moreThanHalf);
+    unsigned int size() const { return centreX.size(); }
+};
+
+// test every probe against every wall. timeOfImpact has one entry per probe
+// and is only ever lowered, so set it to LIGHT_TRAIL_NO_HIT before the first call
+void collideStraights(const LightTrailProbes &probes, const LightTrailStraightBatch &straights, float *timeOfImpact);
+void collideArcs(const LightTrailProbes &probes, const LightTrailArcBatch &arcs, float *timeOfImpact);
+
+// single tests, these are what the batched versions do for each probe / wall pair
+// returns LIGHT_TRAIL_NO_HIT if they don't touch
+float collideStraight(const glm::vec2 &from, const glm::vec2 &to,
+                      const glm::vec2 &start, const glm::vec2 &end);
+float collideArc(const glm::vec2 &from, const glm::vec2 &to,
+                 const glm::vec2 &centre, float radiusSquared,
+                 const glm::vec2 &startDirection, const glm::vec2 &stopDirection,
+                 float turnSign, bool moreThanHalf);
+
+#endif
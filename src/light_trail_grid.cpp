@@ -0,0 +1,214 @@
+#include "light_trail_grid.hpp"
+#include "light_trail_segment_store.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+LightTrailGrid::LightTrailGrid(std::shared_ptr<const LightTrailSegmentStore> _store, float _cellSize)
+    : store(_store), cellSize(_cellSize)
+{
+}
+
+LightTrailGrid::~LightTrailGrid()
+{
+}
+
+LightTrailGrid::CellKey LightTrailGrid::getKey(int x, int z) const
+{
+    // pack both cell co-ords into one 64 bit key
+    return ((CellKey)x << 32) | (CellKey)(unsigned int)z;
+}
+
+LightTrailGrid::CellRange LightTrailGrid::getCellRange(const glm::vec2 &min, const glm::vec2 &max) const
+{
+    CellRange range;
+    range.minX = (int)floor(min.x / cellSize);
+    range.minZ = (int)floor(min.y / cellSize);
+    range.maxX = (int)floor(max.x / cellSize);
+    range.maxZ = (int)floor(max.y / cellSize);
+    return range;
+}
+
+void LightTrailGrid::addToCells(LightTrailSegmentHandle segment, const CellRange &range, const CellRange *alreadyAdded)
+{
+    for (int x = range.minX; x <= range.maxX; x++)
+    {
+        for (int z = range.minZ; z <= range.maxZ; z++)
+        {
+            // skip cells we've already been added to
+            if (alreadyAdded &&
+                x >= alreadyAdded->minX && x <= alreadyAdded->maxX &&
+                z >= alreadyAdded->minZ && z <= alreadyAdded->maxZ)
+            {
+                continue;
+            }
+            cells[getKey(x, z)].push_back(segment);
+        }
+    }
+}
+
+void LightTrailGrid::insert(LightTrailSegmentHandle segment)
+{
+    glm::vec2 min, max;
+    store->getBounds(segment, min, max);
+
+    CellRange range = getCellRange(min, max);
+    addToCells(segment, range, NULL);
+    segmentRanges[segment] = range;
+}
+
+void LightTrailGrid::update(LightTrailSegmentHandle segment)
+{
+    auto it = segmentRanges.find(segment);
+    if (it == segmentRanges.end())
+    {
+        insert(segment);
+        return;
+    }
+
+    glm::vec2 min, max;
+    store->getBounds(segment, min, max);
+
+    // segments only ever grow, but take the union anyway
+    // so we never lose track of a cell we are in
+    CellRange oldRange = it->second;
+    CellRange newRange = getCellRange(min, max);
+    newRange.minX = std::min(newRange.minX, oldRange.minX);
+    newRange.minZ = std::min(newRange.minZ, oldRange.minZ);
+    newRange.maxX = std::max(newRange.maxX, oldRange.maxX);
+    newRange.maxZ = std::max(newRange.maxZ, oldRange.maxZ);
+
+    if (newRange.minX == oldRange.minX && newRange.minZ == oldRange.minZ &&
+        newRange.maxX == oldRange.maxX && newRange.maxZ == oldRange.maxZ)
+    {
+        // still in the same cells, nothing to do
+        return;
+    }
+
+    addToCells(segment, newRange, &oldRange);
+    it->second = newRange;
+}
+
+void LightTrailGrid::remove(LightTrailSegmentHandle segment)
+{
+    auto it = segmentRanges.find(segment);
+    if (it == segmentRanges.end())
+    {
+        return;
+    }
+
+    const CellRange &range = it->second;
+    for (int x = range.minX; x <= range.maxX; x++)
+    {
+        for (int z = range.minZ; z <= range.maxZ; z++)
+        {
+            auto cellIt = cells.find(getKey(x, z));
+            if (cellIt == cells.end())
+            {
+                continue;
+            }
+
+            Cell &cell = cellIt->second;
+            cell.erase(std::remove(cell.begin(), cell.end(), segment), cell.end());
+            if (cell.empty())
+            {
+                cells.erase(cellIt);
+            }
+        }
+    }
+
+    segmentRanges.erase(it);
+}
+
+bool LightTrailGrid::collides(const glm::vec2 &from, const glm::vec2 &to, float &timeOfImpact) const
+{
+    // any segment we could cross must overlap the bounding box of the move
+    CellRange range = getCellRange(glm::min(from, to), glm::max(from, to));
+
+    bool hit = false;
+    for (int x = range.minX; x <= range.maxX; x++)
+    {
+        for (int z = range.minZ; z <= range.maxZ; z++)
+        {
+            auto cellIt = cells.find(getKey(x, z));
+            if (cellIt == cells.end())
+            {
+                continue;
+            }
+
+            // keep looking after a hit, as we want the first segment we cross
+            for (auto segment : cellIt->second)
+            {
+                float t;
+                if (store->collides(segment, from, to, t) &&
+                    (!hit || t < timeOfImpact))
+                {
+                    timeOfImpact = t;
+                    hit = true;
+                }
+            }
+        }
+    }
+    return hit;
+}
+
+bool LightTrailGrid::collides(const LightTrailProbes &probes, float *timeOfImpact) const
+{
+    unsigned int numProbes = probes.size();
+
+    // find every segment near any of the probes, only once each
+    candidates.clear();
+    for (unsigned int i = 0; i < numProbes; i++)
+    {
+        glm::vec2 from(probes.fromX[i], probes.fromZ[i]);
+        glm::vec2 to(probes.toX[i], probes.toZ[i]);
+        CellRange range = getCellRange(glm::min(from, to), glm::max(from, to));
+        for (int x = range.minX; x <= range.maxX; x++)
+        {
+            for (int z = range.minZ; z <= range.maxZ; z++)
+            {
+                auto cellIt = cells.find(getKey(x, z));
+                if (cellIt != cells.end())
+                {
+                    candidates.insert(candidates.end(), cellIt->second.begin(), cellIt->second.end());
+                }
+            }
+        }
+        timeOfImpact[i] = LIGHT_TRAIL_NO_HIT;
+    }
+    std::sort(candidates.begin(), candidates.end());
+    candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+
+    straightBatch.clear();
+    arcBatch.clear();
+    for (auto segment : candidates)
+    {
+        if (!store->addToBatch(segment, straightBatch, arcBatch))
+        {
+            // spirals don't batch, so test them against each probe
+            for (unsigned int i = 0; i < numProbes; i++)
+            {
+                float t;
+                if (store->collides(segment,
+                                    glm::vec2(probes.fromX[i], probes.fromZ[i]),
+                                    glm::vec2(probes.toX[i], probes.toZ[i]),
+                                    t))
+                {
+                    timeOfImpact[i] = std::min(timeOfImpact[i], t);
+                }
+            }
+        }
+    }
+
+    collideStraights(probes, straightBatch, timeOfImpact);
+    collideArcs(probes, arcBatch, timeOfImpact);
+
+    for (unsigned int i = 0; i < numProbes; i++)
+    {
+        if (timeOfImpact[i] < LIGHT_TRAIL_NO_HIT)
+        {
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,76 @@
+#ifndef __LIGHT_TRAIL_GRID_HPP
+#define __LIGHT_TRAIL_GRID_HPP
+
+#include "light_trail_collision_kernel.hpp"
+#include "light_trail_segment.hpp"
+
+#include <glm/glm.hpp>
+
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+// size of each (square) cell in world units
+// big enough that a segment normally only covers a few cells
+// small enough that each cell only contains a few segments
+#define LIGHT_TRAIL_GRID_CELL_SIZE      10.0f
+
+class LightTrailSegmentStore;
+
+// Uniform grid over the XZ plane used as a broad phase for
+// light trail collision detection. Each cell stores the segments
+// whose bounding box overlaps it, so a collision check only has to
+// look at the segments near the query, rather than every
+// segment of every light trail.
+class LightTrailGrid
+{
+public:
+    LightTrailGrid(std::shared_ptr<const LightTrailSegmentStore> _store,
+                   float _cellSize = LIGHT_TRAIL_GRID_CELL_SIZE);
+    ~LightTrailGrid();
+
+    void insert(LightTrailSegmentHandle segment);
+
+    // call after the segment has been extended, so we add it to any new cells
+    void update(LightTrailSegmentHandle segment);
+
+    void remove(LightTrailSegmentHandle segment);
+
+    // does moving from 'from' to 'to' cross any segment?
+    // if so timeOfImpact is set to how far along the move (0 -> 1) we first hit one
+    bool collides(const glm::vec2 &from, const glm::vec2 &to, float &timeOfImpact) const;
+
+    // the same for lots of moves at once (eg. several points on each bike)
+    // timeOfImpact needs an entry per probe, and is set to LIGHT_TRAIL_NO_HIT
+    // for those that don't hit anything. Returns true if any of them hit.
+    bool collides(const LightTrailProbes &probes, float *timeOfImpact) const;
+
+protected:
+    struct CellRange
+    {
+        int minX;
+        int minZ;
+        int maxX;
+        int maxZ;
+    };
+
+    typedef long long CellKey;
+    typedef std::vector<LightTrailSegmentHandle> Cell;
+
+    CellKey getKey(int x, int z) const;
+    CellRange getCellRange(const glm::vec2 &min, const glm::vec2 &max) const;
+    void addToCells(LightTrailSegmentHandle segment, const CellRange &range, const CellRange *alreadyAdded);
+
+    std::shared_ptr<const LightTrailSegmentStore> store;
+    float cellSize;
+
+    std::unordered_map<CellKey, Cell> cells;
+    std::unordered_map<LightTrailSegmentHandle, CellRange> segmentRanges;
+
+    // scratch space for the batched collides(), kept so we don't allocate every query
+    mutable std::vector<LightTrailSegmentHandle> candidates;
+    mutable LightTrailStraightBatch straightBatch;
+    mutable LightTrailArcBatch arcBatch;
+};
+
+#endif
@@ -1,11 +1,20 @@
 #include "light_trail_manager.hpp"
 #include "light_trail.hpp"
+#include "light_trail_grid.hpp"
+#include "light_trail_segment_store.hpp"
 
 LightTrailManager::LightTrailManager(std::shared_ptr<World> _world,
                                      std::shared_ptr<const Shader> _shader,
-                                     glm::vec3 _colour)
-    : world(_world), shader(_shader), colour(_colour),
-      state(STATE_STOPPED), lastTurning(NO_TURN), lastAccelerating(SPEED_NORMAL)
+                                     std::shared_ptr<const Shader> _debugShader,
+                                     glm::vec3 _colour,
+                                     float _worldScale,
+                                     float _compactionMaxError)
+    : world(_world), shader(_shader), colour(_colour), worldScale(_worldScale),
+      compactionMaxError(_compactionMaxError),
+      state(STATE_STOPPED),
+      segmentStore(std::make_shared<LightTrailSegmentStore>(_world, _debugShader)),
+      grid(std::make_shared<LightTrailGrid>(segmentStore)),
+      lastTurning(NO_TURN), lastAccelerating(SPEED_NORMAL)
 {
 }
 
@@ -26,7 +35,16 @@ void LightTrailManager::toggle()
         // we are either stopped or stopping.
         // deosn't matter create new light trail
         state = STATE_ON;
-        trails.push_back(std::make_unique<LightTrail>(world, shader, colour, lastTurning, lastAccelerating));
+        if (spareTrails.size())
+        {
+            trails.push_back(std::move(spareTrails.back()));
+            spareTrails.pop_back();
+            trails.back()->start(lastTurning, lastAccelerating);
+        }
+        else
+        {
+            trails.push_back(std::make_unique<LightTrail>(world, shader, segmentStore, grid, colour, worldScale, compactionMaxError, lastTurning, lastAccelerating));
+        }
     }
 }
 
@@ -41,7 +59,7 @@ void LightTrailManager::turnOff()
     // else we are already stopping or stopped, nothing to do.
 }
 
-void LightTrailManager::update(TurnDirection turning, Accelerating accelerating, float speed, glm::vec3 currentLocation, float currentAngleRads)
+void LightTrailManager::update(TurnDirection turning, Accelerating accelerating, float speed, glm::vec3 currentLocation, unsigned int currentHeading)
 {
     lastTurning = turning;
     lastAccelerating = accelerating;
@@ -49,7 +67,7 @@ void LightTrailManager::update(TurnDirection turning, Accelerating accelerating,
     std::for_each(trails.begin(), trails.end(),
         [&](std::unique_ptr<LightTrail> &trail)
         {
-            trail->update(turning, accelerating, speed, currentLocation, currentAngleRads);
+            trail->update(turning, accelerating, speed, currentLocation, currentHeading);
         });
 
     // lets see if we can delete any
@@ -59,20 +77,20 @@ void LightTrailManager::update(TurnDirection turning, Accelerating accelerating,
     //  As any past that can't be dead yet either
     while (trails.size() && trails.front()->isDead())
     {
-        trails.erase(trails.begin());
+        trails.front()->reset();
+        spareTrails.push_back(std::move(trails.front()));
+        trails.pop_front();
     }
 }
 
-bool LightTrailManager::collides(const glm::vec2 &location) const
+bool LightTrailManager::collides(const glm::vec2 &from, const glm::vec2 &to, float &timeOfImpact) const
 {
-    for (auto &t : trails)
-    {
-        if (t->collides(location))
-        {
-            return true;
-        }
-    }
-    return false;
+    return grid->collides(from, to, timeOfImpact);
+}
+
+bool LightTrailManager::collides(const LightTrailProbes &probes, float *timeOfImpact) const
+{
+    return grid->collides(probes, timeOfImpact);
 }
 
 bool LightTrailManager::checkSelfCollision() const
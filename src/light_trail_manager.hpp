@@ -4,30 +4,44 @@
 #include "bike_movements.hpp"
 
 #include <vector>
+#include <deque>
 #include <memory>
 #include <algorithm>
 
 #include <glm/glm.hpp>
 
+// old light trail segments get combined into fewer, simpler ones,
+// this is how far (in world units) that's allowed to move the walls
+#define LIGHT_TRAIL_COMPACTION_MAX_ERROR    0.01f
+
 class World;
 class Shader;
 class LightTrail;
+class LightTrailSegmentStore;
+class LightTrailGrid;
+struct LightTrailProbes;
 
 class LightTrailManager
 {
 public:
     LightTrailManager(std::shared_ptr<World> _world,
                       std::shared_ptr<const Shader> _shader,
-                      glm::vec3 _colour);
+                      std::shared_ptr<const Shader> _debugShader,     // for the segment debug meshes
+                      glm::vec3 _colour,
+                      float _worldScale,
+                      float _compactionMaxError = LIGHT_TRAIL_COMPACTION_MAX_ERROR);
     ~LightTrailManager();
 
     // turn on or off the light trail
     void toggle();
     void turnOff();
 
-    void update(TurnDirection turning, Accelerating accelerating, float speed, glm::vec3 currentLocation, float currentAngleRads);
+    void update(TurnDirection turning, Accelerating accelerating, float speed, glm::vec3 currentLocation, unsigned int currentHeading);
 
-    bool collides(const glm::vec2 &location) const;
+    // does moving from 'from' to 'to' cross any of our light trails?
+    bool collides(const glm::vec2 &from, const glm::vec2 &to, float &timeOfImpact) const;
+    // the same for lots of moves at once, see LightTrailGrid::collides()
+    bool collides(const LightTrailProbes &probes, float *timeOfImpact) const;
     bool checkSelfCollision() const;
 
     // draw all the light trails
@@ -44,10 +58,19 @@ protected:
     std::shared_ptr<World> world;
     std::shared_ptr<const Shader> shader;
     glm::vec3 colour;
+    float worldScale;   // world units per unit of bike speed
+    float compactionMaxError;
 
     State state;
 
-    std::vector<std::unique_ptr<LightTrail>> trails;
+    // oldest first, they die in the order they were made
+    std::deque<std::unique_ptr<LightTrail>> trails;
+    // dead trails, kept to reuse their buffers and memory for new ones
+    std::vector<std::unique_ptr<LightTrail>> spareTrails;
+
+    // the segments of all our trails, and a spatial index of them
+    std::shared_ptr<LightTrailSegmentStore> segmentStore;
+    std::shared_ptr<LightTrailGrid> grid;
 
     TurnDirection lastTurning;
     Accelerating lastAccelerating;
@@ -1,4 +1,7 @@
 #include "light_trail_segment.hpp"
+#include "light_trail_collision_kernel.hpp"
+#include "light_trail_spiral_table.hpp"
+#include "heading.hpp"
 
 #ifdef DEBUG_SHOW_LIGHT_TRAIL_SEGMENTS
 #include "object.hpp"
@@ -11,49 +14,101 @@
 #define DEBUG_LTS_STRAIGHT_COLOUR   glm::vec3(1.0f, 0.0f, 0.0f)
 #define DEBUG_LTS_CIRCLE_COLOUR     glm::vec3(0.0f, 1.0f, 0.0f)
 #define DEBUG_LTS_SPIRAL_COLOUR     glm::vec3(0.0f, 0.0f, 1.0f)
+#define DEBUG_LTS_POLYLINE_COLOUR   glm::vec3(1.0f, 1.0f, 0.0f)
 
-#define EPSILON         0.05f
-#define CIRCLE_EPSILON  0.6f
+// a circle that's gone round more than 330 degrees will hit itself
+#define CIRCLE_SELF_COLLISION_STEPS ((unsigned int)(330.0f / ANGLE_OF_TURNS))
+
+// newton's method normally gets there in 3 or 4 goes
+#define SPIRAL_SOLVER_ITERATIONS    16
+// in frames
+#define SPIRAL_SOLVER_TOLERANCE     0.0001f
+
+// the spiral can bow out between the points in the LightTrailSpiralTable
+// by (length between points)^2 / (8 * radius), which is < 0.01
+#define SPIRAL_BOUNDS_PADDING       0.05f
+
+// polylines are tested edge by edge, and go in the grid as one,
+// so stop them getting too long or too spread out
+#define POLYLINE_MAX_POINTS         32
+// in world units, the same as a LightTrailGrid cell
+#define POLYLINE_MAX_SIZE           10.0f
 
 #ifdef DEBUG_ALLOW_SELECTING_ACTIVE_LIGHT_TRAIL_SEGMENT
 unsigned int LightTrailSegment::totalSegments = 0;
 unsigned int LightTrailSegment::activeSegmentID = 0;
 #endif
 
-LightTrailSegment::LightTrailSegment(std::shared_ptr<World> _world, std::shared_ptr<const Shader> _shader)
-    : world(_world), shader(_shader)
+LightTrailSegment::LightTrailSegment()
 {
 #ifdef DEBUG_ALLOW_SELECTING_ACTIVE_LIGHT_TRAIL_SEGMENT
     segmentID = ++totalSegments;
 #endif
 }
 
-LightTrailSegment::~LightTrailSegment()
+#ifdef DEBUG_SHOW_LIGHT_TRAIL_SEGMENTS
+void LightTrailSegment::createDebugObject(std::shared_ptr<World> world, std::shared_ptr<const Shader> shader, const glm::vec3 &colour)
 {
+    debugObjData = std::make_shared<ObjData3D>();
+    debugMesh = debugObjData->addMesh(debugMeshData);
+    if (debugMesh == INVALID_MESH_HANDLE)
+    {
+        // fali
+        printf("Failed to create light trail segment %s obj data\n", debugMeshData.name.c_str());
+    }
+    debugObj = std::make_unique<Object>(debugObjData, world, shader, glm::mat4(1.0f), colour);
 }
 
 void LightTrailSegment::drawDebugMesh() const
 {
-#ifdef DEBUG_SHOW_LIGHT_TRAIL_SEGMENTS
     if (debugObj)
     {
 #ifdef DEBUG_ALLOW_SELECTING_ACTIVE_LIGHT_TRAIL_SEGMENT
-        if (activeSegmentID == 0 ||
-            activeSegmentID == segmentID)
+        if (isActive())
 #endif
         {
             debugObj->drawAll();
         }
     }
+}
+
+void LightTrailSegment::destroyDebugMesh()
+{
+    debugObj.reset();
+    debugObjData.reset();
+}
 #endif
+
+#ifdef DEBUG_ALLOW_SELECTING_ACTIVE_LIGHT_TRAIL_SEGMENT
+bool LightTrailSegment::isActive() const
+{
+    return (activeSegmentID == 0 ||
+            activeSegmentID == segmentID);
+}
+#endif
+
+float distanceToLineSegment(const glm::vec2 &point, const glm::vec2 &start, const glm::vec2 &end)
+{
+    glm::vec2 line = end - start;
+    float lengthSquared = glm::dot(line, line);
+    if (lengthSquared == 0.0f)
+    {
+        return glm::distance(point, start);
+    }
+    float t = glm::clamp(glm::dot(point - start, line) / lengthSquared, 0.0f, 1.0f);
+    return glm::distance(point, start + (t * line));
 }
 
 // STRAIGHT ===================================================================
 
-LightTrailSegmentStraight::LightTrailSegmentStraight(const glm::vec2 &_start, float currentAngleRads, std::shared_ptr<World> _world, std::shared_ptr<const Shader> _shader)
-    : LightTrailSegment(_world, _shader), start(_start), end(_start)
+LightTrailSegmentStraight::LightTrailSegmentStraight(const glm::vec2 &_start)
+    : start(_start), end(_start)
 {
+}
+
 #ifdef DEBUG_SHOW_LIGHT_TRAIL_SEGMENTS
+void LightTrailSegmentStraight::createDebugMesh(std::shared_ptr<World> world, std::shared_ptr<const Shader> shader)
+{
     debugMeshData.name = "LTS_STRAIGHT";
     debugMeshData.hasTexture = false;
 
@@ -62,7 +117,8 @@ LightTrailSegmentStraight::LightTrailSegmentStraight(const glm::vec2 &_start, fl
     debugMeshData.vertices.push_back(glm::vec3(end.x,   DEBUG_MESH_DATA_HEIGHT, end.y));
     debugMeshData.vertices.push_back(glm::vec3(end.x,   0, end.y));
 
-    glm::vec3 normal = glm::normalize(glm::vec3(glm::vec4(1,0,0,1) * glm::rotate(currentAngleRads, glm::vec3(0,-1,0))));
+    // we don't know which way we're going yet, update() sorts this out
+    glm::vec3 normal(1,0,0);
     debugMeshData.normals.push_back(normal);
     debugMeshData.normals.push_back(normal);
     debugMeshData.normals.push_back(normal);
@@ -71,35 +127,38 @@ LightTrailSegmentStraight::LightTrailSegmentStraight(const glm::vec2 &_start, fl
     debugMeshData.indices.push_back(0); debugMeshData.indices.push_back(1); debugMeshData.indices.push_back(2);
     debugMeshData.indices.push_back(0); debugMeshData.indices.push_back(2); debugMeshData.indices.push_back(3);
 
-    debugObjData = std::make_shared<ObjData3D>();
-    if (!debugObjData->addMesh(debugMeshData))
+    createDebugObject(world, shader, DEBUG_LTS_STRAIGHT_COLOUR);
+}
+#endif
+
+bool LightTrailSegmentStraight::collides(const glm::vec2 &from, const glm::vec2 &to, float &timeOfImpact) const
+{
+#ifdef DEBUG_ALLOW_SELECTING_ACTIVE_LIGHT_TRAIL_SEGMENT
+    if (!isActive())
     {
-        // fali
-        printf("Failed to create light trail segment straight obj data\n");
+        return false;
     }
-    debugObj = std::make_unique<Object>(debugObjData, world, shader, glm::mat4(1.0f), DEBUG_LTS_STRAIGHT_COLOUR);
 #endif
-}
 
-LightTrailSegmentStraight::~LightTrailSegmentStraight()
-{
+    float t = collideStraight(from, to, start, end);
+    if (t == LIGHT_TRAIL_NO_HIT)
+    {
+        return false;
+    }
+    timeOfImpact = t;
+    return true;
 }
 
-bool LightTrailSegmentStraight::collides(const glm::vec2 &location) const
+void LightTrailSegmentStraight::addToBatch(LightTrailStraightBatch &batch) const
 {
 #ifdef DEBUG_ALLOW_SELECTING_ACTIVE_LIGHT_TRAIL_SEGMENT
-    if (activeSegmentID != 0 &&
-        activeSegmentID != segmentID)
+    if (!isActive())
     {
-        return false;
+        return;
     }
 #endif
 
-    // distance(a,p) + distance(b,p) == distance(a,b)
-    float dist = abs(glm::distance(location, start) +
-                     glm::distance(location, end) -
-                     glm::distance(end, start));
-    return (dist < EPSILON);
+    batch.add(start, end);
 }
 
 bool LightTrailSegmentStraight::checkSelfCollision() const
@@ -108,7 +167,7 @@ bool LightTrailSegmentStraight::checkSelfCollision() const
     return false;
 }
 
-void LightTrailSegmentStraight::update(const glm::vec2 &currentLocation, float currentAngleRads)
+void LightTrailSegmentStraight::update(const glm::vec2 &currentLocation, unsigned int currentHeading)
 {
     end = currentLocation;
 
@@ -118,27 +177,58 @@ void LightTrailSegmentStraight::update(const glm::vec2 &currentLocation, float c
     debugMeshData.vertices.push_back(glm::vec3(end.x,   DEBUG_MESH_DATA_HEIGHT, end.y));
     debugMeshData.vertices.push_back(glm::vec3(end.x,   0, end.y));
 
-    debugObjData->updateMesh(debugMeshData);
+    if (end != start)
+    {
+        glm::vec3 normal = glm::cross(glm::normalize(glm::vec3(end.x - start.x, 0, end.y - start.y)),
+                                      glm::vec3(0,1,0));
+        for (auto &n : debugMeshData.normals)
+        {
+            n = normal;
+        }
+    }
+
+    debugObjData->updateMesh(debugMesh, debugMeshData);
     debugObjData->updateBuffers();
 #endif
 }
 
+void LightTrailSegmentStraight::getBounds(glm::vec2 &min, glm::vec2 &max) const
+{
+    min = glm::min(start, end);
+    max = glm::max(start, end);
+}
+
+void LightTrailSegmentStraight::appendPoints(std::vector<glm::vec2> &points) const
+{
+    if (points.empty())
+    {
+        points.push_back(start);
+    }
+    points.push_back(end);
+}
+
 // CIRCLE =====================================================================
 
-LightTrailSegmentCircle::LightTrailSegmentCircle(const glm::vec2 &_centre, float _radius, float _startAngleRads, TurnDirection _turnDirection, std::shared_ptr<World> _world, std::shared_ptr<const Shader> _shader)
-    : LightTrailSegment(_world, _shader),
-      centre(_centre), radius(_radius),
-      startAngleRads(_startAngleRads), stopAngleRads(_startAngleRads),
-      turnDirection(_turnDirection)
+LightTrailSegmentCircle::LightTrailSegmentCircle(const glm::vec2 &_centre, float _radius, unsigned int _startHeading, TurnDirection _turnDirection)
+    : centre(_centre), radius(_radius),
+      turnDirection(_turnDirection),
+      startHeading(_startHeading), lastHeading(_startHeading), headingStepsTurned(0)
 {
-    // make stopAngleRads a little past start angle rads, so we don't coollide
-    // on first check.
-    stopAngleRads += (turnDirection == TURN_RIGHT) ? 0.001f : -0.001f;
+    startDirection = Heading::forward(_startHeading);
+
+    // make stopDirection a little past startDirection, so we don't coollide
+    // on first check. (-y, x) is 90 degrees to the right
+    float turnSign = (turnDirection == TURN_RIGHT) ? 1.0f : -1.0f;
+    stopDirection = glm::normalize(startDirection + (0.001f * turnSign * glm::vec2(-startDirection.y, startDirection.x)));
+}
+
 #ifdef DEBUG_SHOW_LIGHT_TRAIL_SEGMENTS
+void LightTrailSegmentCircle::createDebugMesh(std::shared_ptr<World> world, std::shared_ptr<const Shader> shader)
+{
     debugMeshData.name = "LTS_CIRCLE";
     debugMeshData.hasTexture = false;
 
-    glm::vec2 tmp(sin(startAngleRads), -cos(startAngleRads));
+    glm::vec2 tmp = startDirection;
     glm::vec2 point = (radius * tmp) + centre;
 
     debugMeshData.vertices.push_back(glm::vec3(point.x, 0, point.y));
@@ -161,37 +251,32 @@ LightTrailSegmentCircle::LightTrailSegmentCircle(const glm::vec2 &_centre, float
     debugMeshData.indices.push_back(numVertices - 1);
     debugMeshData.indices.push_back(numVertices - 2);
 
-    debugObjData = std::make_shared<ObjData3D>();
-    if (!debugObjData->addMesh(debugMeshData))
-    {
-        // fali
-        printf("Failed to create light trail segment circle obj data\n");
-    }
-    debugObj = std::make_unique<Object>(debugObjData, world, shader, glm::mat4(1.0f), DEBUG_LTS_CIRCLE_COLOUR);
-#endif
+    createDebugObject(world, shader, DEBUG_LTS_CIRCLE_COLOUR);
 }
+#endif
 
-LightTrailSegmentCircle::~LightTrailSegmentCircle()
+void LightTrailSegmentCircle::update(const glm::vec2 &currentLocation, unsigned int currentHeading)
 {
-}
+    stopDirection = glm::normalize(currentLocation - centre);
 
-void LightTrailSegmentCircle::update(const glm::vec2 &currentLocation, float currentAngleRads)
-{
-    // need angle between centre and -ve Z
-    // and centre and currentLocation
-    // A DOT B = |A||B| cos theta
-    // unfortunately I can only then recover theta to between 0 and PI
-    // which makes it hard to work out what our actual angle is
-    // I check if we are left or right of the centre and adjust if needed
+    // the bike is facing 90 degrees round from the direction from our centre to it,
+    // count how many steps that's turned since last time so we know how far round
+    // we've been, even once we've gone past our start
+    unsigned int heading = (turnDirection == TURN_RIGHT) ? currentHeading + NUM_HEADINGS - (NUM_HEADINGS / 4) :
+                                                           currentHeading + (NUM_HEADINGS / 4);
+    heading %= NUM_HEADINGS;
+    headingStepsTurned += Heading::stepsBetween(lastHeading, heading, turnDirection);
+    lastHeading = heading;
 
-    stopAngleRads = glm::acos(glm::dot(glm::vec2(0,-1), glm::normalize(currentLocation - centre)));
-    if (currentLocation.x < centre.x)
-    {
-        stopAngleRads = 2*glm::pi<float>() - stopAngleRads;
-    }
+#ifdef DEBUG_SHOW_LIGHT_TRAIL_SEGMENTS
+    addDebugMeshPoint(stopDirection);
+#endif
+}
 
 #ifdef DEBUG_SHOW_LIGHT_TRAIL_SEGMENTS
-    glm::vec2 tmp(sin(stopAngleRads), -cos(stopAngleRads));
+void LightTrailSegmentCircle::addDebugMeshPoint(const glm::vec2 &direction)
+{
+    glm::vec2 tmp = direction;
     glm::vec2 point = (radius * tmp) + centre;
 
     debugMeshData.vertices.push_back(glm::vec3(point.x, 0, point.y));
@@ -210,200 +295,138 @@ void LightTrailSegmentCircle::update(const glm::vec2 &currentLocation, float cur
     debugMeshData.indices.push_back(numVertices - 1);
     debugMeshData.indices.push_back(numVertices - 2);
 
-    debugObjData->updateMesh(debugMeshData);
+    debugObjData->updateMesh(debugMesh, debugMeshData);
     debugObjData->updateBuffers();
-#endif
 }
+#endif
 
-bool LightTrailSegmentCircle::collides(const glm::vec2 &location) const
+bool LightTrailSegmentCircle::collides(const glm::vec2 &from, const glm::vec2 &to, float &timeOfImpact) const
 {
 #ifdef DEBUG_ALLOW_SELECTING_ACTIVE_LIGHT_TRAIL_SEGMENT
-    if (activeSegmentID != 0 &&
-        activeSegmentID != segmentID)
+    if (!isActive())
     {
         return false;
     }
 #endif
 
-    // first am I a distance of radius away from the centre
-    float dist = abs(glm::distance(location, centre) - radius);
-    if (dist > CIRCLE_EPSILON)
+    float t = collideArc(from, to, centre, radius * radius,
+                         startDirection, stopDirection,
+                         (turnDirection == TURN_RIGHT) ? 1.0f : -1.0f,
+                         isMoreThanHalf());
+    if (t == LIGHT_TRAIL_NO_HIT)
     {
         return false;
     }
+    timeOfImpact = t;
+    return true;
+}
 
-    float currentAngleRads = glm::acos(glm::dot(glm::vec2(0,-1), glm::normalize(location - centre)));
-    if (location.x < centre.x)
+void LightTrailSegmentCircle::addToBatch(LightTrailArcBatch &batch) const
+{
+#ifdef DEBUG_ALLOW_SELECTING_ACTIVE_LIGHT_TRAIL_SEGMENT
+    if (!isActive())
     {
-        currentAngleRads = 2*glm::pi<float>() - currentAngleRads;
+        return;
     }
+#endif
 
-    // now am I within the start and end angle
-    // two cases, turning left, turning right
-    if (turnDirection == TURN_RIGHT)
+    batch.add(centre, radius, startDirection, stopDirection,
+              (turnDirection == TURN_RIGHT) ? 1.0f : -1.0f,
+              isMoreThanHalf());
+}
+
+bool LightTrailSegmentCircle::isMoreThanHalf() const
+{
+    // the cross product tells us which side of startDirection we've got to,
+    // but it's no good near 0 or 360 degrees where rounding could flip it.
+    // the steps we've turned are only roughly right (the bike is a bit off
+    // the circle), but they are fine to rule those cases out.
+    if (headingStepsTurned < (NUM_HEADINGS / 4))
     {
-        // two more cases
-        // 1) segment doesn't cross angle 0 (start < end)
-        // 2) segment crosses angle 0, (start > end)
-        if (startAngleRads < stopAngleRads)
-        {
-            // current angle is between start and end
-            return (currentAngleRads > startAngleRads &&
-                    currentAngleRads < stopAngleRads);
-        }
-        else
-        {
-            // current angle is > start || < end
-            return (currentAngleRads > startAngleRads ||
-                    currentAngleRads < stopAngleRads);
-        }
+        return false;
     }
-    else // turning left
+    if (headingStepsTurned > ((3 * NUM_HEADINGS) / 4))
     {
-        // two more cases
-        // 1) segment doesn't cross angle 0 (end < start)
-        // 2) segment crosses angle 0, (end > start)
-        if (stopAngleRads < startAngleRads)
-        {
-            // current angle is between start and end
-            return (currentAngleRads < startAngleRads &&
-                    currentAngleRads > stopAngleRads);
-        }
-        else
-        {
-            // current angle is < start || > end
-            return (currentAngleRads < startAngleRads ||
-                    currentAngleRads > stopAngleRads);
-        }
+        return true;
     }
+
+    float turnSign = (turnDirection == TURN_RIGHT) ? 1.0f : -1.0f;
+    float cross = (startDirection.x * stopDirection.y) - (startDirection.y * stopDirection.x);
+    return (turnSign * cross) < 0.0f;
 }
 
 bool LightTrailSegmentCircle::checkSelfCollision() const
 {
 #ifdef DEBUG_ALLOW_SELECTING_ACTIVE_LIGHT_TRAIL_SEGMENT
-    if (activeSegmentID != 0 &&
-        activeSegmentID != segmentID)
+    if (!isActive())
     {
         return false;
     }
 #endif
 
-    // calculate angle of current arch
-    float theta;
+    return (headingStepsTurned > CIRCLE_SELF_COLLISION_STEPS);
+}
+
+void LightTrailSegmentCircle::getBounds(glm::vec2 &min, glm::vec2 &max) const
+{
+    // just use the whole circle, the arc can't get any bigger than that
+    // and it means our bounds don't change as the arc grows
+    min = centre - glm::vec2(radius, radius);
+    max = centre + glm::vec2(radius, radius);
+}
 
-    // two cases, turning left, turning right
-    if (turnDirection == TURN_RIGHT)
+void LightTrailSegmentCircle::appendPoints(std::vector<glm::vec2> &points) const
+{
+    if (points.empty())
     {
-        // two more cases
-        // 1) segment doesn't cross angle 0 (start < end)
-        // 2) segment crosses angle 0, (start > end)
-        if (startAngleRads < (stopAngleRads+0.01f))
-        {
-            theta = stopAngleRads - startAngleRads;
-        }
-        else
-        {
-            theta = stopAngleRads + (2*glm::pi<float>() - startAngleRads);
-        }
+        points.push_back(centre + (radius * startDirection));
     }
-    else // turning left
+
+    // the bike turned one heading step each frame
+    unsigned int heading = startHeading;
+    for (unsigned int i = 1; i < headingStepsTurned; i++)
     {
-        // two more cases
-        // 1) segment doesn't cross angle 0 (end < start)
-        // 2) segment crosses angle 0, (end > start)
-        if (stopAngleRads < (startAngleRads+0.01f))
-        {
-            theta = startAngleRads - stopAngleRads;
-        }
-        else
-        {
-            theta = startAngleRads + (2*glm::pi<float>() - stopAngleRads);
-        }
+        heading = Heading::turn(heading, turnDirection);
+        points.push_back(centre + (radius * Heading::forward(heading)));
     }
-
-    return (theta > glm::radians(330.0f));
+    points.push_back(centre + (radius * stopDirection));
 }
 
 // SPIRAL =====================================================================
 
-LightTrailSegmentSpiral::LightTrailSegmentSpiral(const glm::vec2 &_startPoint, float _startSpeed, float _startAngleRads, TurnDirection _turnDirection, Accelerating _accelerating, std::shared_ptr<World> _world, std::shared_ptr<const Shader> _shader)
-    : LightTrailSegment(_world, _shader),
-      startSpeed(_startSpeed), startAngleRads(_startAngleRads),
-      endAngleRads(_startAngleRads), startPoint(_startPoint),
-      turnDirection(_turnDirection), accelerating(_accelerating)
+LightTrailSegmentSpiral::LightTrailSegmentSpiral(const glm::vec2 &_startPoint, float _startSpeed, unsigned int _startHeading, TurnDirection _turnDirection, Accelerating _accelerating, float _worldScale)
+    : shape(&LightTrailSpiralTable::getShape(_startSpeed, _turnDirection, _accelerating)),
+      turnDirection(_turnDirection), startHeading(_startHeading), endHeading(_startHeading),
+      startAngleRads(Heading::radians(_startHeading)),
+      cosStartAngle(Heading::cos(_startHeading)), sinStartAngle(Heading::sin(_startHeading)),
+      startPoint(_startPoint), worldScale(_worldScale), boundsMin(_startPoint), boundsMax(_startPoint),
+      boundsLastPoint(0)
 #ifdef DEBUG_SHOW_LIGHT_TRAIL_SEGMENTS
       , debugLastTDrawn(0)
 #endif
 {
-    // cache all spiral co-ords indexed by angle from start position
-    // with -ve Z being 0 radians
-
-    // we can calculate which values of T we need to run the calculation for
-    // based on max speed, start speed and acceleration
-    float maxT;
-    if (accelerating == SPEED_ACCELERATE)
-    {
-        maxT = (BIKE_SPEED_FASTEST - startSpeed) / RATE_OF_ACCELERATE;
-    }
-    else
-    {
-        maxT = (startSpeed - BIKE_SPEED_SLOWEST) / RATE_OF_ACCELERATE;
-    }
-
-    // calculate for half values of T. Since the bike can move at a max speed
-    // of 0.6 units per second, whole values of T correspond to points on the
-    // spiral that are at most 0.6 units apart. Therefore half values of T
-    // shouldn't be further than 0.3 unites apart
-
-#ifdef DEBUG_SHOW_LIGHT_TRAIL_SEGMENTS
-    glm::vec2 lastPoint;
-    bool first = true;
-#endif
+    // the centre of curvature at T=0, see getClosestT()
+    startCentre = startPoint + rotateToWorld(glm::vec2(shape->startSpeed / shape->C, 0.0f));
+}
 
-    // stick in T=0 into the cache
-    cache.insert(SpiralCacheMapValue(0.0f, startPoint));
 #ifdef DEBUG_SHOW_LIGHT_TRAIL_SEGMENTS
-    debugMeshData.vertices.push_back(glm::vec3(startPoint.x, 0, startPoint.y));
-    debugMeshData.vertices.push_back(glm::vec3(startPoint.x, DEBUG_MESH_DATA_HEIGHT, startPoint.y));
-#endif
-
-    for (float T = 0.5f; T < (maxT + 0.6f); T+=0.5f)
+void LightTrailSegmentSpiral::createDebugMesh(std::shared_ptr<World> world, std::shared_ptr<const Shader> shader)
+{
+    // one pair of vertices for each point in the table
+    for (unsigned int i = 0; i < shape->points.size(); i++)
     {
-        glm::vec2 point = calculateSpiralCoOrdsForT(T);
+        glm::vec2 point = startPoint + rotateToWorld(shape->points[i]);
 
-        // stick it in the cache
-        cache.insert(SpiralCacheMapValue(T, point));
-
-#ifdef DEBUG_SHOW_LIGHT_TRAIL_SEGMENTS
         debugMeshData.vertices.push_back(glm::vec3(point.x, 0, point.y));
         debugMeshData.vertices.push_back(glm::vec3(point.x, DEBUG_MESH_DATA_HEIGHT, point.y));
 
-        glm::vec2 difference;
-        if (first)
-        {
-            difference = point - startPoint;
-        }
-        else
-        {
-            difference = point - lastPoint;
-        }
-        glm::vec3 normal = glm::cross(glm::normalize(glm::vec3(difference.x, 0, difference.y)),
+        glm::vec2 velocity = calculateSpiralVelocityForT((float)i);
+        glm::vec3 normal = glm::cross(glm::normalize(glm::vec3(velocity.x, 0, velocity.y)),
                                       glm::vec3(0,1,0));
-        if (first)
-        {
-            // need to push two more normals for vertex T=0
-            debugMeshData.normals.push_back(normal);
-            debugMeshData.normals.push_back(normal);
-            first = false;
-        }
         debugMeshData.normals.push_back(normal);
         debugMeshData.normals.push_back(normal);
-
-        lastPoint = point;
-#endif
     }
 
-#ifdef DEBUG_SHOW_LIGHT_TRAIL_SEGMENTS
     debugMeshData.name = "LTS_SPIRAL";
     debugMeshData.hasTexture = false;
 
@@ -411,18 +434,15 @@ LightTrailSegmentSpiral::LightTrailSegmentSpiral(const glm::vec2 &_startPoint, f
     // bit of a nasty hack, but it'll work
     debugMeshData.indices.push_back(0); debugMeshData.indices.push_back(0); debugMeshData.indices.push_back(0);
 
-    debugObjData = std::make_shared<ObjData3D>();
-    if (!debugObjData->addMesh(debugMeshData))
-    {
-        // fali
-        printf("Failed to create light trail segment spiral obj data\n");
-    }
-    debugObj = std::make_unique<Object>(debugObjData, world, shader, glm::mat4(1.0f), DEBUG_LTS_SPIRAL_COLOUR);
-#endif
+    createDebugObject(world, shader, DEBUG_LTS_SPIRAL_COLOUR);
 }
+#endif
 
-LightTrailSegmentSpiral::~LightTrailSegmentSpiral()
+glm::vec2 LightTrailSegmentSpiral::rotateToWorld(const glm::vec2 &v) const
 {
+    // rotate from a spiral starting at angle 0 to ours, and scale to world units
+    return worldScale * glm::vec2((v.x * cosStartAngle) - (v.y * sinStartAngle),
+                                  (v.x * sinStartAngle) + (v.y * cosStartAngle));
 }
 
 glm::vec2 LightTrailSegmentSpiral::calculateSpiralCoOrdsForT(float T) const
@@ -435,63 +455,270 @@ glm::vec2 LightTrailSegmentSpiral::calculateSpiralCoOrdsForT(float T) const
     // T = frame number since spiral start
     // U = initial speed
     // Theta = initial angle of bike
-    float C = (turnDirection == TURN_RIGHT) ? glm::radians(ANGLE_OF_TURNS) : -glm::radians(ANGLE_OF_TURNS);
-    float A = (accelerating == SPEED_ACCELERATE) ? RATE_OF_ACCELERATE : -RATE_OF_ACCELERATE;
-    float U = startSpeed;
-    float Theta = startAngleRads;
 
-    float cosTheta = cos(Theta);
-    float sinTheta = sin(Theta);
-    float cosCTPlusTheta = cos(C * T + Theta);
-    float sinCTPlusTheta = sin(C * T + Theta);
+    // we work it out for Theta = 0 (same as the LightTrailSpiralTable)
+    // and rotate it, which saves half the trig
+    float C = shape->C;
+    float A = shape->A;
+    float U = shape->startSpeed;
+
+    float cosCT = cos(C * T);
+    float sinCT = sin(C * T);
 
-    float pointX = (U / C) * (cosTheta - cosCTPlusTheta) +
-                   (A / (C * C)) * (sinCTPlusTheta - sinTheta) -
-                   (A * T / C) * (cosCTPlusTheta);
+    float pointX = (U / C) * (1.0f - cosCT) +
+                   (A / (C * C)) * sinCT -
+                   (A * T / C) * cosCT;
 
-    float pointZ = (U / C) * (sinCTPlusTheta - sinTheta) +
-                   (A / (C * C)) * (cosCTPlusTheta - cosTheta) +
-                   (A * T / C) * (sinCTPlusTheta);
+    float pointZ = (U / C) * sinCT +
+                   (A / (C * C)) * (cosCT - 1.0f) +
+                   (A * T / C) * sinCT;
 
     // using -pointZ as my spiral equation assumes angle 0
     // equates to +ve Z whereas it's actually -ve
-    return glm::vec2(pointX, -pointZ) + startPoint;
+    return rotateToWorld(glm::vec2(pointX, -pointZ)) + startPoint;
+}
+
+glm::vec2 LightTrailSegmentSpiral::calculateSpiralVelocityForT(float T) const
+{
+    // differentiating the above, the bike moves at speed U+AT
+    // in the direction it is facing (CT+Theta)
+    float angle = shape->C * T;
+    return rotateToWorld((shape->startSpeed + shape->A * T) * glm::vec2(sin(angle), -cos(angle)));
+}
+
+glm::vec2 LightTrailSegmentSpiral::calculateSpiralAccelerationForT(float T) const
+{
+    float angle = shape->C * T;
+    float sinAngle = sin(angle);
+    float cosAngle = cos(angle);
+    return rotateToWorld((shape->A * glm::vec2(sinAngle, -cosAngle)) +
+                         ((shape->startSpeed + shape->A * T) * shape->C * glm::vec2(cosAngle, sinAngle)));
+}
+
+float LightTrailSegmentSpiral::getLastT() const
+{
+    // CT+Theta = end angle, and we turn C radians every step
+    return Heading::stepsBetween(startHeading, endHeading, turnDirection) * glm::radians(ANGLE_OF_TURNS) / glm::abs(shape->C);
 }
 
-bool LightTrailSegmentSpiral::collides(const glm::vec2 &location) const
+float LightTrailSegmentSpiral::getClosestT(const glm::vec2 &point, float maxT) const
+{
+    float C = shape->C;
+
+    // the distance to point is at a minimum where (P(T) - point).P'(T) = 0
+    // the spiral turns less than half a circle, so that's normally
+    // the only turning point, and we can solve for it with newton's method,
+    // keeping it within a bracket that we know the answer is in.
+
+    // the centre of curvature only moves slowly (at A/C) so start from
+    // where the closest point would be on the circle we started turning on.
+    // on that circle the point at angle CT+Theta is at
+    // centre - (U/C)(cos(CT+Theta), sin(CT+Theta))
+    glm::vec2 fromCentre = point - startCentre;
+    float angle = atan2(fromCentre.y, fromCentre.x);
+    if (C > 0.0f)
+    {
+        angle += glm::pi<float>();
+    }
+
+    // wrap it so we get the closest match to the part of the spiral we have
+    float angleTurned = (angle - startAngleRads) * glm::sign(C);
+    float midAngle = glm::abs(C) * maxT / 2.0f;
+    angleTurned -= glm::two_pi<float>() * floor((angleTurned - midAngle + glm::pi<float>()) / glm::two_pi<float>());
+
+    float lo = 0.0f;
+    float hi = maxT;
+    float T = glm::clamp(angleTurned / glm::abs(C), lo, hi);
+
+    for (int i = 0; i < SPIRAL_SOLVER_ITERATIONS; i++)
+    {
+        glm::vec2 offset = calculateSpiralCoOrdsForT(T) - point;
+        glm::vec2 velocity = calculateSpiralVelocityForT(T);
+
+        // -ve means we're still getting closer, so the minimum is further on
+        float gradient = glm::dot(offset, velocity);
+        if (gradient < 0.0f)
+        {
+            lo = T;
+        }
+        else
+        {
+            hi = T;
+        }
+
+        float gradientDash = glm::dot(velocity, velocity) +
+                             glm::dot(offset, calculateSpiralAccelerationForT(T));
+        float nextT = (gradientDash > 0.0f) ? (T - (gradient / gradientDash)) : ((lo + hi) / 2.0f);
+        if (nextT <= lo || nextT >= hi)
+        {
+            // newton's gone out of the bracket, bisect instead
+            nextT = (lo + hi) / 2.0f;
+        }
+
+        bool done = glm::abs(nextT - T) < SPIRAL_SOLVER_TOLERANCE;
+        T = nextT;
+        if (done)
+        {
+            break;
+        }
+    }
+
+    // the ends could still be closer
+    float bestT = T;
+    float bestDist = glm::distance(calculateSpiralCoOrdsForT(T), point);
+    float ends[2] = { 0.0f, maxT };
+    for (float end : ends)
+    {
+        float dist = glm::distance(calculateSpiralCoOrdsForT(end), point);
+        if (dist < bestDist)
+        {
+            bestDist = dist;
+            bestT = end;
+        }
+    }
+    return bestT;
+}
+
+float LightTrailSegmentSpiral::getSideOfLineT(const glm::vec2 &lineStart, const glm::vec2 &lineDirection,
+                                              float lo, float hi, float loSide) const
+{
+    // side(T) = cross(lineDirection, P(T) - lineStart) is monotonic between lo and hi
+    // and changes sign somewhere in there, find where
+    float T = (lo + hi) / 2.0f;
+    for (int i = 0; i < SPIRAL_SOLVER_ITERATIONS; i++)
+    {
+        glm::vec2 offset = calculateSpiralCoOrdsForT(T) - lineStart;
+        glm::vec2 velocity = calculateSpiralVelocityForT(T);
+
+        float side = (lineDirection.x * offset.y) - (lineDirection.y * offset.x);
+        float sideDash = (lineDirection.x * velocity.y) - (lineDirection.y * velocity.x);
+
+        if ((side < 0.0f) == (loSide < 0.0f))
+        {
+            lo = T;
+        }
+        else
+        {
+            hi = T;
+        }
+
+        float nextT = (sideDash != 0.0f) ? (T - (side / sideDash)) : ((lo + hi) / 2.0f);
+        if (nextT <= lo || nextT >= hi)
+        {
+            nextT = (lo + hi) / 2.0f;
+        }
+
+        bool done = glm::abs(nextT - T) < SPIRAL_SOLVER_TOLERANCE;
+        T = nextT;
+        if (done)
+        {
+            break;
+        }
+    }
+    return T;
+}
+
+bool LightTrailSegmentSpiral::collides(const glm::vec2 &from, const glm::vec2 &to, float &timeOfImpact) const
 {
 #ifdef DEBUG_ALLOW_SELECTING_ACTIVE_LIGHT_TRAIL_SEGMENT
-    if (activeSegmentID != 0 &&
-        activeSegmentID != segmentID)
+    if (!isActive())
     {
         return false;
     }
 #endif
 
-    // check all points in the cache (up to where the bike got to).
-    // and see if we are in range of any of them.
-    float turnAngleRads = glm::radians(ANGLE_OF_TURNS);
-    if (turnDirection == TURN_LEFT)
+    glm::vec2 d = to - from;
+    float moveLength = glm::length(d);
+    if (moveLength == 0.0f)
     {
-        turnAngleRads = -turnAngleRads;
+        return false;
     }
 
-    float lastT = (endAngleRads - startAngleRads) / turnAngleRads;
+    float lastT = getLastT();
+    if (lastT <= 0.0f)
+    {
+        return false;
+    }
+
+    // the centre of curvature moves at most |A/C| * T away from where it
+    // started, and the radius is (U + AT)/|C|, so everything we've drawn
+    // so far lies in an annulus around the starting centre.
+    float C = shape->C;
+    float U = shape->startSpeed;
+    float endRadius = U + (2.0f * shape->A * lastT);
+    float innerRadius = worldScale * glm::max(0.0f, glm::min(U, endRadius)) / glm::abs(C);
+    float outerRadius = worldScale * glm::max(U, endRadius) / glm::abs(C);
+
+    // entirely inside the inner circle?
+    if (glm::distance(from, startCentre) < innerRadius &&
+        glm::distance(to, startCentre) < innerRadius)
+    {
+        return false;
+    }
+
+    // entirely outside the outer circle?
+    float along = glm::clamp(glm::dot(startCentre - from, d) / glm::dot(d, d), 0.0f, 1.0f);
+    if (glm::distance(from + (along * d), startCentre) > outerRadius)
+    {
+        return false;
+    }
+
+    // can't reach the spiral if it's further away than we're moving
+    float closestT = getClosestT(from, lastT);
+    if (glm::distance(calculateSpiralCoOrdsForT(closestT), from) > moveLength)
+    {
+        return false;
+    }
 
-    for (auto &it : cache)
+    // which side of our line each point of the spiral is on is
+    // side(T) = cross(d, P(T) - from). This only turns round where the
+    // spiral is parallel to d, which happens every half turn, so split
+    // the spiral up at those points and look for a sign change in each part
+    float parallelAngle = atan2(-d.x, d.y);
+    float angleTurned = (parallelAngle - startAngleRads) * glm::sign(C);
+    angleTurned -= glm::pi<float>() * floor(angleTurned / glm::pi<float>());
+
+    bool hit = false;
+    float lo = 0.0f;
+    while (lo < lastT)
     {
-        if (it.first > (lastT + 0.1f))
+        float hi = glm::min(angleTurned / glm::abs(C), lastT);
+        angleTurned += glm::pi<float>();
+        if (hi <= lo)
         {
-            break;
+            continue;
         }
-        float distToPoint = abs(glm::distance(location, it.second));
-        if (distToPoint < CIRCLE_EPSILON)
+
+        glm::vec2 loOffset = calculateSpiralCoOrdsForT(lo) - from;
+        glm::vec2 hiOffset = calculateSpiralCoOrdsForT(hi) - from;
+        float loSide = (d.x * loOffset.y) - (d.y * loOffset.x);
+        float hiSide = (d.x * hiOffset.y) - (d.y * hiOffset.x);
+
+        if ((loSide <= 0.0f && hiSide >= 0.0f) ||
+            (loSide >= 0.0f && hiSide <= 0.0f))
         {
-            return true;
+            float crossingT = getSideOfLineT(from, d, lo, hi, loSide);
+            float t = glm::dot(calculateSpiralCoOrdsForT(crossingT) - from, d) / glm::dot(d, d);
+            if (t >= 0.0f && t <= 1.0f &&
+                (!hit || t < timeOfImpact))
+            {
+                timeOfImpact = t;
+                hit = true;
+            }
         }
+
+        lo = hi;
     }
 
-    return false;
+    return hit;
+}
+
+void LightTrailSegmentSpiral::getBounds(glm::vec2 &min, glm::vec2 &max) const
+{
+    // the curve bows out a tiny bit between the points in the table
+    glm::vec2 padding(SPIRAL_BOUNDS_PADDING, SPIRAL_BOUNDS_PADDING);
+    min = boundsMin - padding;
+    max = boundsMax + padding;
 }
 
 bool LightTrailSegmentSpiral::checkSelfCollision() const
@@ -500,35 +727,33 @@ bool LightTrailSegmentSpiral::checkSelfCollision() const
     return false;
 }
 
-void LightTrailSegmentSpiral::update(const glm::vec2 &currentLocation, float currentAngleRads)
+void LightTrailSegmentSpiral::update(const glm::vec2 &currentLocation, unsigned int currentHeading)
 {
-    endAngleRads = currentAngleRads;
+    endHeading = currentHeading;
+
+    // grow our bounds to cover the points of the spiral we've now gone past
+    float T = getLastT();
+    unsigned int lastPoint = glm::min((unsigned int)glm::max(0.0f, T), (unsigned int)shape->points.size() - 1);
+    for (; boundsLastPoint < lastPoint; boundsLastPoint++)
+    {
+        glm::vec2 point = startPoint + rotateToWorld(shape->points[boundsLastPoint + 1]);
+        boundsMin = glm::min(boundsMin, point);
+        boundsMax = glm::max(boundsMax, point);
+    }
+    // and where we are now
+    glm::vec2 endPoint = calculateSpiralCoOrdsForT(T);
+    boundsMin = glm::min(boundsMin, glm::min(endPoint, currentLocation));
+    boundsMax = glm::max(boundsMax, glm::max(endPoint, currentLocation));
 
 #ifdef DEBUG_SHOW_LIGHT_TRAIL_SEGMENTS
     bool anythingChanged = false;
 
-    // CT+Theta = currentAngleRads
-    float C = (turnDirection == TURN_RIGHT) ? glm::radians(ANGLE_OF_TURNS) : -glm::radians(ANGLE_OF_TURNS);
-    float T = (currentAngleRads - startAngleRads) / C;
-
-    // we have debugMeshData for 1/2 values of T, 0.5, 1, 1.5, ...
-    float t;
-    for (t = debugLastTDrawn + 0.5f; (t+0.1f) <= T; t+=0.5f)
+    // vertices 2T and 2T+1 are for the point at T,
+    // so draw a face between each pair of points we've gone past
+    unsigned int t;
+    for (t = debugLastTDrawn + 1; (t - 0.1f) <= T; t++)
     {
-        // vertices 0,1 are for T = 0.5
-        //          2,3 are for T = 1
-        // etc...
-
-        // so we need to draw a face that ends with vertices defined by t
-        // and starts with those defined by t-0.5
-
-        if (t < 0.4f)
-        {
-            // t is 0.5f ie. there is no vertices defined by t-0.5
-            continue;
-        }
-
-        unsigned int startVertexNum = (unsigned int)round((t - 0.5f)*4.0f);
+        unsigned int startVertexNum = (t - 1) * 2;
         if (startVertexNum + 3 >= debugMeshData.vertices.size())
         {
             // not enough vertices?
@@ -542,14 +767,221 @@ void LightTrailSegmentSpiral::update(const glm::vec2 &currentLocation, float cur
         debugMeshData.indices.push_back(startVertexNum + 3);
         debugMeshData.indices.push_back(startVertexNum + 2);
 
-        anythingChanged = 1;
+        anythingChanged = true;
     }
-    debugLastTDrawn = t-0.5f;
+    debugLastTDrawn = t - 1;
 
     if (anythingChanged)
     {
-        debugObjData->updateMesh(debugMeshData);
+        debugObjData->updateMesh(debugMesh, debugMeshData);
         debugObjData->updateBuffers();
     }
 #endif
 }
+
+void LightTrailSegmentSpiral::appendPoints(std::vector<glm::vec2> &points) const
+{
+    if (points.empty())
+    {
+        points.push_back(startPoint);
+    }
+
+    // we've got a point for every frame in our shape
+    float T = getLastT();
+    unsigned int lastPoint = glm::min((unsigned int)glm::max(0.0f, T), (unsigned int)shape->points.size() - 1);
+    for (unsigned int i = 1; i < lastPoint; i++)
+    {
+        points.push_back(startPoint + rotateToWorld(shape->points[i]));
+    }
+    points.push_back(calculateSpiralCoOrdsForT(T));
+}
+
+// POLYLINE ===================================================================
+
+static bool isPolylineTooBig(unsigned int numPoints, const glm::vec2 &min, const glm::vec2 &max)
+{
+    glm::vec2 size = max - min;
+    return (numPoints > POLYLINE_MAX_POINTS ||
+            size.x > POLYLINE_MAX_SIZE ||
+            size.y > POLYLINE_MAX_SIZE);
+}
+
+bool LightTrailSegmentPolyline::simplify(const std::vector<glm::vec2> &points, float maxError, std::vector<glm::vec2> &result)
+{
+    result.clear();
+    if (points.size() < 2)
+    {
+        return false;
+    }
+
+    result.push_back(points[0]);
+    simplifyPath(points, 0, points.size() - 1, maxError,
+                 [&](unsigned int i) { result.push_back(points[i]); });
+
+    glm::vec2 min = result[0];
+    glm::vec2 max = result[0];
+    for (auto &p : result)
+    {
+        min = glm::min(min, p);
+        max = glm::max(max, p);
+    }
+    return !isPolylineTooBig(result.size(), min, max);
+}
+
+LightTrailSegmentPolyline::LightTrailSegmentPolyline(std::vector<glm::vec2> &&_points)
+    : points(std::move(_points))
+{
+    calculateBounds();
+}
+
+void LightTrailSegmentPolyline::swapPoints(std::vector<glm::vec2> &newPoints)
+{
+    points.swap(newPoints);
+    calculateBounds();
+}
+
+void LightTrailSegmentPolyline::calculateBounds()
+{
+    boundsMin = points[0];
+    boundsMax = points[0];
+    for (auto &p : points)
+    {
+        boundsMin = glm::min(boundsMin, p);
+        boundsMax = glm::max(boundsMax, p);
+    }
+}
+
+#ifdef DEBUG_SHOW_LIGHT_TRAIL_SEGMENTS
+void LightTrailSegmentPolyline::buildDebugMeshData()
+{
+    debugMeshData.vertices.clear();
+    debugMeshData.normals.clear();
+    debugMeshData.indices.clear();
+
+    for (unsigned int i = 0; i < points.size(); i++)
+    {
+        debugMeshData.vertices.push_back(glm::vec3(points[i].x, 0, points[i].y));
+        debugMeshData.vertices.push_back(glm::vec3(points[i].x, DEBUG_MESH_DATA_HEIGHT, points[i].y));
+
+        // use the direction of the edge before (or after for the first point)
+        glm::vec2 edge = (i > 0) ? points[i] - points[i - 1] : points[1] - points[0];
+        glm::vec3 normal(1,0,0);
+        if (edge != glm::vec2(0,0))
+        {
+            normal = glm::cross(glm::normalize(glm::vec3(edge.x, 0, edge.y)), glm::vec3(0,1,0));
+        }
+        debugMeshData.normals.push_back(normal);
+        debugMeshData.normals.push_back(normal);
+
+        if (i > 0)
+        {
+            unsigned int numVertices = debugMeshData.vertices.size();
+            debugMeshData.indices.push_back(numVertices - 4);
+            debugMeshData.indices.push_back(numVertices - 3);
+            debugMeshData.indices.push_back(numVertices - 1);
+
+            debugMeshData.indices.push_back(numVertices - 4);
+            debugMeshData.indices.push_back(numVertices - 1);
+            debugMeshData.indices.push_back(numVertices - 2);
+        }
+    }
+}
+
+void LightTrailSegmentPolyline::createDebugMesh(std::shared_ptr<World> world, std::shared_ptr<const Shader> shader)
+{
+    debugMeshData.name = "LTS_POLYLINE";
+    debugMeshData.hasTexture = false;
+
+    buildDebugMeshData();
+    createDebugObject(world, shader, DEBUG_LTS_POLYLINE_COLOUR);
+}
+#endif
+
+bool LightTrailSegmentPolyline::collides(const glm::vec2 &from, const glm::vec2 &to, float &timeOfImpact) const
+{
+#ifdef DEBUG_ALLOW_SELECTING_ACTIVE_LIGHT_TRAIL_SEGMENT
+    if (!isActive())
+    {
+        return false;
+    }
+#endif
+
+    // keep looking after a hit, as we want the first edge we cross
+    float t = LIGHT_TRAIL_NO_HIT;
+    for (unsigned int i = 1; i < points.size(); i++)
+    {
+        t = glm::min(t, collideStraight(from, to, points[i - 1], points[i]));
+    }
+    if (t == LIGHT_TRAIL_NO_HIT)
+    {
+        return false;
+    }
+    timeOfImpact = t;
+    return true;
+}
+
+void LightTrailSegmentPolyline::addToBatch(LightTrailStraightBatch &batch) const
+{
+#ifdef DEBUG_ALLOW_SELECTING_ACTIVE_LIGHT_TRAIL_SEGMENT
+    if (!isActive())
+    {
+        return;
+    }
+#endif
+
+    for (unsigned int i = 1; i < points.size(); i++)
+    {
+        batch.add(points[i - 1], points[i]);
+    }
+}
+
+bool LightTrailSegmentPolyline::checkSelfCollision() const
+{
+    // only made from finished segments, the bike can't be drawing us
+    return false;
+}
+
+void LightTrailSegmentPolyline::update(const glm::vec2 &currentLocation, unsigned int currentHeading)
+{
+    // nothing to do, we never get extended by the bike
+}
+
+void LightTrailSegmentPolyline::getBounds(glm::vec2 &min, glm::vec2 &max) const
+{
+    min = boundsMin;
+    max = boundsMax;
+}
+
+bool LightTrailSegmentPolyline::append(const std::vector<glm::vec2> &morePoints, float maxError, std::vector<glm::vec2> &simplified)
+{
+    // only simplify the new points, so the error doesn't build up on the old ones
+    simplify(morePoints, maxError, simplified);
+    if (simplified.empty())
+    {
+        return false;
+    }
+
+    glm::vec2 min = boundsMin;
+    glm::vec2 max = boundsMax;
+    for (auto &p : simplified)
+    {
+        min = glm::min(min, p);
+        max = glm::max(max, p);
+    }
+    // simplified[0] is our end, so don't count it twice
+    if (isPolylineTooBig(points.size() + simplified.size() - 1, min, max))
+    {
+        return false;
+    }
+
+    points.insert(points.end(), simplified.begin() + 1, simplified.end());
+    boundsMin = min;
+    boundsMax = max;
+
+#ifdef DEBUG_SHOW_LIGHT_TRAIL_SEGMENTS
+    buildDebugMeshData();
+    debugObjData->updateMesh(debugMesh, debugMeshData);
+    debugObjData->updateBuffers();
+#endif
+    return true;
+}
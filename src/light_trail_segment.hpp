@@ -9,26 +9,60 @@
 
 #include <glm/glm.hpp>
 
-#include <map>
 #include <memory>
+#include <vector>
 
 class World;
 class Shader;
 class ObjData3D;
 class Object;
 template <typename T> struct MeshData;
+struct LightTrailStraightBatch;
+struct LightTrailArcBatch;
+struct LightTrailSpiralShape;
 
+// segments are plain values with no virtual functions, they are stored
+// by type in the LightTrailSegmentStore and referenced with these handles
+
+enum LightTrailSegmentType
+{
+    LTS_STRAIGHT = 0,
+    LTS_CIRCLE,
+    LTS_SPIRAL,
+    LTS_POLYLINE,
+};
+
+// type in the top 2 bits, index into that type's array in the rest
+typedef unsigned int LightTrailSegmentHandle;
+#define LTS_HANDLE_TYPE_SHIFT   30
+#define LTS_HANDLE_INDEX_MASK   ((1u << LTS_HANDLE_TYPE_SHIFT) - 1)
+
+inline LightTrailSegmentHandle makeSegmentHandle(LightTrailSegmentType type, unsigned int index)
+{
+    return ((unsigned int)type << LTS_HANDLE_TYPE_SHIFT) | index;
+}
+
+inline LightTrailSegmentType getSegmentHandleType(LightTrailSegmentHandle handle)
+{
+    return (LightTrailSegmentType)(handle >> LTS_HANDLE_TYPE_SHIFT);
+}
+
+inline unsigned int getSegmentHandleIndex(LightTrailSegmentHandle handle)
+{
+    return handle & LTS_HANDLE_INDEX_MASK;
+}
+
+// common debug bits shared by all segment types.
+// in a normal build this is empty
 class LightTrailSegment
 {
 public:
-    LightTrailSegment(std::shared_ptr<World> _world, std::shared_ptr<const Shader> _shader);
-    virtual ~LightTrailSegment();
-
-    virtual bool collides(const glm::vec2 &location) const = 0;
-    virtual bool checkSelfCollision() const = 0;
-    virtual void update(const glm::vec2 &currentLocation, float currentAngleRads) = 0;
+    LightTrailSegment();
 
+#ifdef DEBUG_SHOW_LIGHT_TRAIL_SEGMENTS
     void drawDebugMesh() const;
+    void destroyDebugMesh();
+#endif
 
 #ifdef DEBUG_ALLOW_SELECTING_ACTIVE_LIGHT_TRAIL_SEGMENT
     static unsigned int getNumSegments() { return totalSegments; }
@@ -36,16 +70,18 @@ public:
 #endif
 
 protected:
-    std::shared_ptr<World> world;
-    std::shared_ptr<const Shader> shader;
-
 #ifdef DEBUG_SHOW_LIGHT_TRAIL_SEGMENTS
+    void createDebugObject(std::shared_ptr<World> world, std::shared_ptr<const Shader> shader, const glm::vec3 &colour);
+
     MeshData<glm::vec3> debugMeshData;
+    MeshHandle debugMesh;
     std::shared_ptr<ObjData3D> debugObjData;
     std::unique_ptr<Object> debugObj;
 #endif
 
 #ifdef DEBUG_ALLOW_SELECTING_ACTIVE_LIGHT_TRAIL_SEGMENT
+    bool isActive() const;
+
     static unsigned int totalSegments;
     static unsigned int activeSegmentID;
     unsigned int segmentID;
@@ -55,12 +91,27 @@ protected:
 class LightTrailSegmentStraight : public LightTrailSegment
 {
 public:
-    LightTrailSegmentStraight(const glm::vec2 &start, float currentAngleRads, std::shared_ptr<World> _world, std::shared_ptr<const Shader> _shader);
-    ~LightTrailSegmentStraight();
+    LightTrailSegmentStraight(const glm::vec2 &start);
+
+    // does moving from 'from' to 'to' cross this segment?
+    // if so timeOfImpact is set to how far along the move (0 -> 1) we hit it
+    bool collides(const glm::vec2 &from, const glm::vec2 &to, float &timeOfImpact) const;
+    bool checkSelfCollision() const;
+    void update(const glm::vec2 &currentLocation, unsigned int currentHeading);
+
+    // axis aligned bounding box in the XZ plane, used by the LightTrailGrid
+    void getBounds(glm::vec2 &min, glm::vec2 &max) const;
+
+    // for testing lots of probes at once, see light_trail_collision_kernel.hpp
+    void addToBatch(LightTrailStraightBatch &batch) const;
 
-    bool collides(const glm::vec2 &location) const override;
-    bool checkSelfCollision() const override;
-    void update(const glm::vec2 &currentLocation, float currentAngleRads) override;
+    // add the points the bike went through along this segment (one per frame)
+    // if points is empty we add our start point too, if not points.back() should be it
+    void appendPoints(std::vector<glm::vec2> &points) const;
+
+#ifdef DEBUG_SHOW_LIGHT_TRAIL_SEGMENTS
+    void createDebugMesh(std::shared_ptr<World> world, std::shared_ptr<const Shader> shader);
+#endif
 
 protected:
     glm::vec2 start;    // only x and z, don't need y
@@ -70,49 +121,175 @@ protected:
 class LightTrailSegmentCircle : public LightTrailSegment
 {
 public:
-    LightTrailSegmentCircle(const glm::vec2 &_centre, float _radius, float _startAngleRads, TurnDirection _turnDirection, std::shared_ptr<World> _world, std::shared_ptr<const Shader> _shader);
-    ~LightTrailSegmentCircle();
+    LightTrailSegmentCircle(const glm::vec2 &_centre, float _radius, unsigned int _startHeading, TurnDirection _turnDirection);
+
+    bool collides(const glm::vec2 &from, const glm::vec2 &to, float &timeOfImpact) const;
+    bool checkSelfCollision() const;
+    void update(const glm::vec2 &currentLocation, unsigned int currentHeading);
+    void getBounds(glm::vec2 &min, glm::vec2 &max) const;
+    void addToBatch(LightTrailArcBatch &batch) const;
+    void appendPoints(std::vector<glm::vec2> &points) const;
 
-    bool collides(const glm::vec2 &location) const override;
-    bool checkSelfCollision() const override;
-    void update(const glm::vec2 &currentLocation, float currentAngleRads) override;
+#ifdef DEBUG_SHOW_LIGHT_TRAIL_SEGMENTS
+    void createDebugMesh(std::shared_ptr<World> world, std::shared_ptr<const Shader> shader);
+#endif
 
 protected:
+    // has the arc gone more than half way round the circle
+    bool isMoreThanHalf() const;
+
+#ifdef DEBUG_SHOW_LIGHT_TRAIL_SEGMENTS
+    // add a face up to the point on the circle in direction
+    void addDebugMeshPoint(const glm::vec2 &direction);
+#endif
+
     glm::vec2 centre;   // only x and z, don't need y
     float radius;
-    float startAngleRads;
-    float stopAngleRads;
+    // unit vectors from the centre to the start and stop of the arc
+    glm::vec2 startDirection;
+    glm::vec2 stopDirection;
     TurnDirection turnDirection;
+    // headings (see heading.hpp) from the centre to the start of the arc, and to the end
+    // of the arc last update, and how many heading steps the arc has turned through in total
+    unsigned int startHeading;
+    unsigned int lastHeading;
+    unsigned int headingStepsTurned;
 };
 
 class LightTrailSegmentSpiral : public LightTrailSegment
 {
 public:
-    LightTrailSegmentSpiral(const glm::vec2 &_startPoint, float _startSpeed, float _startAngleRads, TurnDirection _turnDirection, Accelerating _accelerating, std::shared_ptr<World> _world, std::shared_ptr<const Shader> _shader);
-    ~LightTrailSegmentSpiral();
+    LightTrailSegmentSpiral(const glm::vec2 &_startPoint, float _startSpeed, unsigned int _startHeading, TurnDirection _turnDirection, Accelerating _accelerating, float _worldScale);
 
-    bool collides(const glm::vec2 &location) const override;
-    bool checkSelfCollision() const override;
-    void update(const glm::vec2 &currentLocation, float currentAngleRads) override;
+    bool collides(const glm::vec2 &from, const glm::vec2 &to, float &timeOfImpact) const;
+    bool checkSelfCollision() const;
+    void update(const glm::vec2 &currentLocation, unsigned int currentHeading);
+    void getBounds(glm::vec2 &min, glm::vec2 &max) const;
+    void appendPoints(std::vector<glm::vec2> &points) const;
+
+#ifdef DEBUG_SHOW_LIGHT_TRAIL_SEGMENTS
+    void createDebugMesh(std::shared_ptr<World> world, std::shared_ptr<const Shader> shader);
+#endif
 
 protected:
+    // rotate a vector from the LightTrailSpiralShape to our angle and scale
+    glm::vec2 rotateToWorld(const glm::vec2 &v) const;
+
     glm::vec2 calculateSpiralCoOrdsForT(float T) const;
+    // first and second derivatives of the above
+    glm::vec2 calculateSpiralVelocityForT(float T) const;
+    glm::vec2 calculateSpiralAccelerationForT(float T) const;
+
+    // how far along the spiral the bike has got
+    float getLastT() const;
 
-    float startSpeed;
+    // T of the point on the spiral (between 0 and maxT) closest to point
+    float getClosestT(const glm::vec2 &point, float maxT) const;
+
+    // T between lo and hi where the spiral crosses the (infinite) line
+    // through lineStart, loSide is which side of the line P(lo) is on
+    float getSideOfLineT(const glm::vec2 &lineStart, const glm::vec2 &lineDirection,
+                         float lo, float hi, float loSide) const;
+
+    // our shape, from the LightTrailSpiralTable
+    const LightTrailSpiralShape *shape;
+
+    TurnDirection turnDirection;
+    unsigned int startHeading;
+    unsigned int endHeading;
     float startAngleRads;
-    float endAngleRads;
+    float cosStartAngle;
+    float sinStartAngle;
     glm::vec2 startPoint;
-    TurnDirection turnDirection;
-    Accelerating accelerating;
+    float worldScale;   // world units per unit of speed
+
+    glm::vec2 startCentre;
 
-    // T -> point on spiral
-    typedef std::map<float, glm::vec2> SpiralCacheMap;
-    typedef SpiralCacheMap::value_type SpiralCacheMapValue;
-    SpiralCacheMap cache;
+    // bounds of the points in shape up to boundsLastPoint, and where we are now
+    glm::vec2 boundsMin;
+    glm::vec2 boundsMax;
+    unsigned int boundsLastPoint;
 
 #ifdef DEBUG_SHOW_LIGHT_TRAIL_SEGMENTS
-    float debugLastTDrawn;
+    unsigned int debugLastTDrawn;
 #endif
 };
 
+float distanceToLineSegment(const glm::vec2 &point, const glm::vec2 &start, const glm::vec2 &end);
+
+// douglas peucker, calls keep(i) in order for each point after first, up to and including
+// last, that's needed so none of the ones in between are more than maxError from the result
+template <typename Keep>
+void simplifyPath(const std::vector<glm::vec2> &points, unsigned int first, unsigned int last, float maxError, Keep keep)
+{
+    // find the point furthest from the line between first and last
+    float maxDistance = 0.0f;
+    unsigned int furthest = first;
+    for (unsigned int i = first + 1; i < last; i++)
+    {
+        float distance = distanceToLineSegment(points[i], points[first], points[last]);
+        if (distance > maxDistance)
+        {
+            maxDistance = distance;
+            furthest = i;
+        }
+    }
+
+    // if it's too far away keep it, and do the same either side of it
+    if (maxDistance > maxError)
+    {
+        simplifyPath(points, first, furthest, maxError, keep);
+        simplifyPath(points, furthest, last, maxError, keep);
+    }
+    else
+    {
+        keep(last);
+    }
+}
+
+// A run of straight walls, used to replace lots of small finished segments
+// (eg. from tapping the turn keys) with something cheaper to test against.
+// Each edge is tested just like a LightTrailSegmentStraight.
+class LightTrailSegmentPolyline : public LightTrailSegment
+{
+public:
+    // simplify points so that none of them are more than maxError away from result
+    // returns false if the result is too big to go in one polyline
+    static bool simplify(const std::vector<glm::vec2> &points, float maxError, std::vector<glm::vec2> &result);
+
+    // _points should already be simplified
+    LightTrailSegmentPolyline(std::vector<glm::vec2> &&_points);
+
+    // take newPoints (already simplified) as our points, and give our old
+    // ones back in newPoints so their storage can be used again
+    void swapPoints(std::vector<glm::vec2> &newPoints);
+
+    bool collides(const glm::vec2 &from, const glm::vec2 &to, float &timeOfImpact) const;
+    bool checkSelfCollision() const;
+    void update(const glm::vec2 &currentLocation, unsigned int currentHeading);
+    void getBounds(glm::vec2 &min, glm::vec2 &max) const;
+    void addToBatch(LightTrailStraightBatch &batch) const;
+
+    const glm::vec2 &getEnd() const { return points.back(); }
+
+    // simplify morePoints and add them on the end, morePoints[0] should be our end
+    // returns false (and leaves us alone) if we'd get too big.
+    // simplified is scratch space, passed in so we don't allocate every time
+    bool append(const std::vector<glm::vec2> &morePoints, float maxError, std::vector<glm::vec2> &simplified);
+
+#ifdef DEBUG_SHOW_LIGHT_TRAIL_SEGMENTS
+    void createDebugMesh(std::shared_ptr<World> world, std::shared_ptr<const Shader> shader);
+#endif
+
+protected:
+#ifdef DEBUG_SHOW_LIGHT_TRAIL_SEGMENTS
+    void buildDebugMeshData();
+#endif
+    void calculateBounds();
+
+    std::vector<glm::vec2> points;
+    glm::vec2 boundsMin;
+    glm::vec2 boundsMax;
+};
+
 #endif
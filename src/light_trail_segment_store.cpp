@@ -0,0 +1,233 @@
+#include "light_trail_segment_store.hpp"
+#include "light_trail_collision_kernel.hpp"
+
+#ifdef DEBUG_SHOW_LIGHT_TRAIL_SEGMENTS
+#include "object.hpp"
+#endif
+
+template <typename T>
+unsigned int LightTrailSegmentStore::Pool<T>::add(T &&segment)
+{
+    // reuse a slot if we can
+    if (freeSlots.size())
+    {
+        unsigned int index = freeSlots.back();
+        freeSlots.pop_back();
+        segments[index] = std::move(segment);
+        return index;
+    }
+
+    segments.push_back(std::move(segment));
+    return segments.size() - 1;
+}
+
+template <typename T>
+void LightTrailSegmentStore::Pool<T>::remove(unsigned int index)
+{
+#ifdef DEBUG_SHOW_LIGHT_TRAIL_SEGMENTS
+    segments[index].destroyDebugMesh();
+#endif
+    freeSlots.push_back(index);
+}
+
+LightTrailSegmentStore::LightTrailSegmentStore(std::shared_ptr<World> _world, std::shared_ptr<const Shader> _shader)
+    : world(_world), shader(_shader)
+{
+}
+
+LightTrailSegmentStore::~LightTrailSegmentStore()
+{
+}
+
+LightTrailSegmentHandle LightTrailSegmentStore::add(LightTrailSegmentStraight &&segment)
+{
+#ifdef DEBUG_SHOW_LIGHT_TRAIL_SEGMENTS
+    segment.createDebugMesh(world, shader);
+#endif
+    return makeSegmentHandle(LTS_STRAIGHT, straights.add(std::move(segment)));
+}
+
+LightTrailSegmentHandle LightTrailSegmentStore::add(LightTrailSegmentCircle &&segment)
+{
+#ifdef DEBUG_SHOW_LIGHT_TRAIL_SEGMENTS
+    segment.createDebugMesh(world, shader);
+#endif
+    return makeSegmentHandle(LTS_CIRCLE, circles.add(std::move(segment)));
+}
+
+LightTrailSegmentHandle LightTrailSegmentStore::add(LightTrailSegmentSpiral &&segment)
+{
+#ifdef DEBUG_SHOW_LIGHT_TRAIL_SEGMENTS
+    segment.createDebugMesh(world, shader);
+#endif
+    return makeSegmentHandle(LTS_SPIRAL, spirals.add(std::move(segment)));
+}
+
+LightTrailSegmentHandle LightTrailSegmentStore::add(LightTrailSegmentPolyline &&segment)
+{
+#ifdef DEBUG_SHOW_LIGHT_TRAIL_SEGMENTS
+    segment.createDebugMesh(world, shader);
+#endif
+    return makeSegmentHandle(LTS_POLYLINE, polylines.add(std::move(segment)));
+}
+
+void LightTrailSegmentStore::remove(LightTrailSegmentHandle handle)
+{
+    unsigned int index = getSegmentHandleIndex(handle);
+    switch (getSegmentHandleType(handle))
+    {
+        case LTS_STRAIGHT:  straights.remove(index);    break;
+        case LTS_CIRCLE:    circles.remove(index);      break;
+        case LTS_SPIRAL:    spirals.remove(index);      break;
+        case LTS_POLYLINE:  polylines.remove(index);    break;
+    }
+}
+
+bool LightTrailSegmentStore::collides(LightTrailSegmentHandle handle, const glm::vec2 &from, const glm::vec2 &to, float &timeOfImpact) const
+{
+    unsigned int index = getSegmentHandleIndex(handle);
+    switch (getSegmentHandleType(handle))
+    {
+        case LTS_STRAIGHT:  return straights.segments[index].collides(from, to, timeOfImpact);
+        case LTS_CIRCLE:    return circles.segments[index].collides(from, to, timeOfImpact);
+        case LTS_SPIRAL:    return spirals.segments[index].collides(from, to, timeOfImpact);
+        case LTS_POLYLINE:  return polylines.segments[index].collides(from, to, timeOfImpact);
+    }
+    return false;
+}
+
+bool LightTrailSegmentStore::checkSelfCollision(LightTrailSegmentHandle handle) const
+{
+    unsigned int index = getSegmentHandleIndex(handle);
+    switch (getSegmentHandleType(handle))
+    {
+        case LTS_STRAIGHT:  return straights.segments[index].checkSelfCollision();
+        case LTS_CIRCLE:    return circles.segments[index].checkSelfCollision();
+        case LTS_SPIRAL:    return spirals.segments[index].checkSelfCollision();
+        case LTS_POLYLINE:  return polylines.segments[index].checkSelfCollision();
+    }
+    return false;
+}
+
+void LightTrailSegmentStore::update(LightTrailSegmentHandle handle, const glm::vec2 &currentLocation, unsigned int currentHeading)
+{
+    unsigned int index = getSegmentHandleIndex(handle);
+    switch (getSegmentHandleType(handle))
+    {
+        case LTS_STRAIGHT:  straights.segments[index].update(currentLocation, currentHeading);    break;
+        case LTS_CIRCLE:    circles.segments[index].update(currentLocation, currentHeading);      break;
+        case LTS_SPIRAL:    spirals.segments[index].update(currentLocation, currentHeading);      break;
+        case LTS_POLYLINE:  polylines.segments[index].update(currentLocation, currentHeading);    break;
+    }
+}
+
+void LightTrailSegmentStore::getBounds(LightTrailSegmentHandle handle, glm::vec2 &min, glm::vec2 &max) const
+{
+    unsigned int index = getSegmentHandleIndex(handle);
+    switch (getSegmentHandleType(handle))
+    {
+        case LTS_STRAIGHT:  straights.segments[index].getBounds(min, max);  break;
+        case LTS_CIRCLE:    circles.segments[index].getBounds(min, max);    break;
+        case LTS_SPIRAL:    spirals.segments[index].getBounds(min, max);    break;
+        case LTS_POLYLINE:  polylines.segments[index].getBounds(min, max);  break;
+    }
+}
+
+bool LightTrailSegmentStore::addToBatch(LightTrailSegmentHandle handle, LightTrailStraightBatch &straightBatch, LightTrailArcBatch &arcBatch) const
+{
+    unsigned int index = getSegmentHandleIndex(handle);
+    switch (getSegmentHandleType(handle))
+    {
+        case LTS_STRAIGHT:  straights.segments[index].addToBatch(straightBatch);    return true;
+        case LTS_CIRCLE:    circles.segments[index].addToBatch(arcBatch);           return true;
+        case LTS_SPIRAL:    return false;
+        case LTS_POLYLINE:  polylines.segments[index].addToBatch(straightBatch);    return true;
+    }
+    return false;
+}
+
+bool LightTrailSegmentStore::appendPoints(LightTrailSegmentHandle handle, std::vector<glm::vec2> &points) const
+{
+    unsigned int numPoints = points.size();
+    unsigned int index = getSegmentHandleIndex(handle);
+    switch (getSegmentHandleType(handle))
+    {
+        case LTS_STRAIGHT:  straights.segments[index].appendPoints(points); break;
+        case LTS_CIRCLE:    circles.segments[index].appendPoints(points);   break;
+        case LTS_SPIRAL:    spirals.segments[index].appendPoints(points);   break;
+        case LTS_POLYLINE:  return false;
+    }
+
+    // long curves are cheaper to test as they are
+    unsigned int numEdges = points.size() - glm::max(numPoints, 1u);
+    if (numEdges > LIGHT_TRAIL_POLYLINE_MAX_SEGMENT_EDGES)
+    {
+        points.resize(numPoints);
+        return false;
+    }
+    return true;
+}
+
+bool LightTrailSegmentStore::combine(LightTrailSegmentHandle first, LightTrailSegmentHandle second, float maxError, LightTrailSegmentHandle &combined)
+{
+    unsigned int firstIndex = getSegmentHandleIndex(first);
+
+    // segments only end when the bike changes what it's doing, so two next to each
+    // other are never the same straight or circle. put their points in a polyline
+    combinePoints.clear();
+    if (getSegmentHandleType(first) == LTS_POLYLINE)
+    {
+        combinePoints.push_back(polylines.segments[firstIndex].getEnd());
+        if (!appendPoints(second, combinePoints) ||
+            !polylines.segments[firstIndex].append(combinePoints, maxError, combineSimplified))
+        {
+            return false;
+        }
+        remove(second);
+        combined = first;
+        return true;
+    }
+
+    if (!appendPoints(first, combinePoints) ||
+        !appendPoints(second, combinePoints) ||
+        !LightTrailSegmentPolyline::simplify(combinePoints, maxError, combineSimplified))
+    {
+        return false;
+    }
+    remove(first);
+    remove(second);
+    combined = addPolyline(combineSimplified);
+    return true;
+}
+
+LightTrailSegmentHandle LightTrailSegmentStore::addPolyline(std::vector<glm::vec2> &points)
+{
+    if (polylines.freeSlots.empty())
+    {
+        // copy, rather than move, so points doesn't lose its storage
+        return add(LightTrailSegmentPolyline(std::vector<glm::vec2>(points)));
+    }
+
+    unsigned int index = polylines.freeSlots.back();
+    polylines.freeSlots.pop_back();
+    LightTrailSegmentPolyline &polyline = polylines.segments[index];
+    polyline.swapPoints(points);
+#ifdef DEBUG_SHOW_LIGHT_TRAIL_SEGMENTS
+    polyline.createDebugMesh(world, shader);
+#endif
+    return makeSegmentHandle(LTS_POLYLINE, index);
+}
+
+#ifdef DEBUG_SHOW_LIGHT_TRAIL_SEGMENTS
+void LightTrailSegmentStore::drawDebugMesh(LightTrailSegmentHandle handle) const
+{
+    unsigned int index = getSegmentHandleIndex(handle);
+    switch (getSegmentHandleType(handle))
+    {
+        case LTS_STRAIGHT:  straights.segments[index].drawDebugMesh();  break;
+        case LTS_CIRCLE:    circles.segments[index].drawDebugMesh();    break;
+        case LTS_SPIRAL:    spirals.segments[index].drawDebugMesh();    break;
+        case LTS_POLYLINE:  polylines.segments[index].drawDebugMesh();  break;
+    }
+}
+#endif
@@ -0,0 +1,86 @@
+#ifndef __LIGHT_TRAIL_SEGMENT_STORE_HPP
+#define __LIGHT_TRAIL_SEGMENT_STORE_HPP
+
+#include "light_trail_segment.hpp"
+
+#include <memory>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+// segments that took more frames than this are left as they are
+// rather than being turned into polylines
+#define LIGHT_TRAIL_POLYLINE_MAX_SEGMENT_EDGES  8
+
+class World;
+class Shader;
+
+// Owns the segments of all the light trails, packed into one array
+// per segment type, so collision checks run over contiguous memory
+// without chasing pointers or making virtual calls.
+// Slots of removed segments are reused, so once we've warmed up
+// adding a segment doesn't allocate.
+class LightTrailSegmentStore
+{
+public:
+    // world and shader are only used to draw the debug meshes
+    LightTrailSegmentStore(std::shared_ptr<World> _world, std::shared_ptr<const Shader> _shader);
+    ~LightTrailSegmentStore();
+
+    LightTrailSegmentHandle add(LightTrailSegmentStraight &&segment);
+    LightTrailSegmentHandle add(LightTrailSegmentCircle &&segment);
+    LightTrailSegmentHandle add(LightTrailSegmentSpiral &&segment);
+    LightTrailSegmentHandle add(LightTrailSegmentPolyline &&segment);
+    void remove(LightTrailSegmentHandle handle);
+
+    bool collides(LightTrailSegmentHandle handle, const glm::vec2 &from, const glm::vec2 &to, float &timeOfImpact) const;
+    bool checkSelfCollision(LightTrailSegmentHandle handle) const;
+    void update(LightTrailSegmentHandle handle, const glm::vec2 &currentLocation, unsigned int currentHeading);
+    void getBounds(LightTrailSegmentHandle handle, glm::vec2 &min, glm::vec2 &max) const;
+
+    // add a straight or circle to the matching batch, for the collision kernel
+    // returns false for anything that can't be batched (spirals)
+    bool addToBatch(LightTrailSegmentHandle handle, LightTrailStraightBatch &straightBatch, LightTrailArcBatch &arcBatch) const;
+
+    // try to replace two finished segments, second following on from first,
+    // with one segment that's never more than maxError away from either.
+    // if we can, both are removed from the store (unless combined is first)
+    bool combine(LightTrailSegmentHandle first, LightTrailSegmentHandle second, float maxError, LightTrailSegmentHandle &combined);
+
+#ifdef DEBUG_SHOW_LIGHT_TRAIL_SEGMENTS
+    void drawDebugMesh(LightTrailSegmentHandle handle) const;
+#endif
+
+protected:
+    // see LightTrailSegmentStraight::appendPoints()
+    // returns false (and leaves points alone) if the segment is too long to go in a polyline
+    bool appendPoints(LightTrailSegmentHandle handle, std::vector<glm::vec2> &points) const;
+
+    // add a polyline made from points. if there's a removed polyline we take over its
+    // slot and swap points with it, so points keeps storage for next time either way
+    LightTrailSegmentHandle addPolyline(std::vector<glm::vec2> &points);
+
+    template <typename T>
+    struct Pool
+    {
+        std::vector<T> segments;
+        std::vector<unsigned int> freeSlots;
+
+        unsigned int add(T &&segment);
+        void remove(unsigned int index);
+    };
+
+    std::shared_ptr<World> world;
+    std::shared_ptr<const Shader> shader;
+
+    Pool<LightTrailSegmentStraight> straights;
+    Pool<LightTrailSegmentCircle> circles;
+    Pool<LightTrailSegmentSpiral> spirals;
+    Pool<LightTrailSegmentPolyline> polylines;
+
+    // scratch space for combine(), kept so we don't allocate every time
+    std::vector<glm::vec2> combinePoints;
+    std::vector<glm::vec2> combineSimplified;
+};
+
+#endif
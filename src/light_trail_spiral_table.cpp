@@ -0,0 +1,70 @@
+#include "light_trail_spiral_table.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+LightTrailSpiralShape LightTrailSpiralTable::shapes[SPIRAL_TABLE_NUM_SPEEDS][2][2];
+
+void LightTrailSpiralTable::setup()
+{
+    for (int speed = 0; speed < SPIRAL_TABLE_NUM_SPEEDS; speed++)
+    {
+        float startSpeed = BIKE_SPEED_SLOWEST + (speed * RATE_OF_ACCELERATE);
+        setupShape(shapes[speed][0][0], startSpeed, TURN_LEFT,  SPEED_BRAKE);
+        setupShape(shapes[speed][0][1], startSpeed, TURN_LEFT,  SPEED_ACCELERATE);
+        setupShape(shapes[speed][1][0], startSpeed, TURN_RIGHT, SPEED_BRAKE);
+        setupShape(shapes[speed][1][1], startSpeed, TURN_RIGHT, SPEED_ACCELERATE);
+    }
+}
+
+void LightTrailSpiralTable::setupShape(LightTrailSpiralShape &shape, float startSpeed, TurnDirection turnDirection, Accelerating accelerating)
+{
+    shape.startSpeed = startSpeed;
+    shape.C = (turnDirection == TURN_RIGHT) ? glm::radians(ANGLE_OF_TURNS) : -glm::radians(ANGLE_OF_TURNS);
+    shape.A = (accelerating == SPEED_ACCELERATE) ? RATE_OF_ACCELERATE : -RATE_OF_ACCELERATE;
+
+    // how many frames until we can't go any faster / slower
+    if (accelerating == SPEED_ACCELERATE)
+    {
+        shape.maxT = (BIKE_SPEED_FASTEST - startSpeed) / RATE_OF_ACCELERATE;
+    }
+    else
+    {
+        shape.maxT = (startSpeed - BIKE_SPEED_SLOWEST) / RATE_OF_ACCELERATE;
+    }
+
+    // formulae for our spiral with Theta = 0
+    // see notes/light_trail_spiral.ods and LightTrailSegmentSpiral
+    float U = startSpeed;
+    float C = shape.C;
+    float A = shape.A;
+
+    unsigned int numPoints = (unsigned int)ceil(shape.maxT) + 2;
+    shape.points.clear();
+    shape.points.reserve(numPoints);
+    for (unsigned int i = 0; i < numPoints; i++)
+    {
+        float T = (float)i;
+        float cosCT = cos(C * T);
+        float sinCT = sin(C * T);
+
+        float pointX = (U / C) * (1.0f - cosCT) +
+                       (A / (C * C)) * sinCT -
+                       (A * T / C) * cosCT;
+
+        float pointZ = (U / C) * sinCT +
+                       (A / (C * C)) * (cosCT - 1.0f) +
+                       (A * T / C) * sinCT;
+
+        shape.points.push_back(glm::vec2(pointX, -pointZ));
+    }
+}
+
+const LightTrailSpiralShape &LightTrailSpiralTable::getShape(float startSpeed, TurnDirection turnDirection, Accelerating accelerating)
+{
+    // snap to the nearest step, so float drift in the bike's speed doesn't matter
+    int speed = (int)floor(((startSpeed - BIKE_SPEED_SLOWEST) / RATE_OF_ACCELERATE) + 0.5f);
+    speed = std::max(0, std::min(SPIRAL_TABLE_NUM_SPEEDS - 1, speed));
+
+    return shapes[speed][(turnDirection == TURN_RIGHT) ? 1 : 0][(accelerating == SPEED_ACCELERATE) ? 1 : 0];
+}
@@ -0,0 +1,42 @@
+#ifndef __LIGHT_TRAIL_SPIRAL_TABLE_HPP
+#define __LIGHT_TRAIL_SPIRAL_TABLE_HPP
+
+#include "bike_movements.hpp"
+
+#include <vector>
+
+#include <glm/glm.hpp>
+
+// the bike's speed only changes in steps of RATE_OF_ACCELERATE
+#define SPIRAL_TABLE_NUM_SPEEDS     ((int)(((BIKE_SPEED_FASTEST - BIKE_SPEED_SLOWEST) / RATE_OF_ACCELERATE) + 0.5f) + 1)
+
+// One spiral, starting at the origin facing along -ve Z
+// with a world scale of 1. Every spiral a light trail makes is one of these
+// rotated by the bike's angle, scaled and moved to where the bike was.
+struct LightTrailSpiralShape
+{
+    float startSpeed;
+    float C;        // angle of turn per frame in radians
+    float A;        // rate of acceleration
+    float maxT;     // when we hit the max / min speed
+
+    // point on the spiral for T = 0, 1, 2, ... up to past maxT
+    std::vector<glm::vec2> points;
+};
+
+// table of every spiral shape, by start speed, turn direction and
+// accelerating or braking. Built once at startup.
+class LightTrailSpiralTable
+{
+public:
+    static void setup();
+    static const LightTrailSpiralShape &getShape(float startSpeed, TurnDirection turnDirection, Accelerating accelerating);
+
+protected:
+    static void setupShape(LightTrailSpiralShape &shape, float startSpeed, TurnDirection turnDirection, Accelerating accelerating);
+
+    // [speed][turning right][accelerating]
+    static LightTrailSpiralShape shapes[SPIRAL_TABLE_NUM_SPEEDS][2][2];
+};
+
+#endif
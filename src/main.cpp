@@ -8,6 +8,9 @@
 #include "progress_bar.hpp"
 #include "texture.hpp"
 #include "light_trail_manager.hpp"
+#include "light_trail_collision_kernel.hpp"
+#include "light_trail_spiral_table.hpp"
+#include "heading.hpp"
 #include "render_pipeline.hpp"
 
 #ifdef DEBUG_ALLOW_SELECTING_ACTIVE_LIGHT_TRAIL_SEGMENT
@@ -67,17 +70,17 @@ std::shared_ptr<ObjData3D> createArena()
     // now to create indices
     // we have (ARENA_NUM_X - 1) * (ARENA_NUM_Z - 1) squares
     // go through each square
-    for (unsigned short x = 0; x < (ARENA_NUM_X - 1); x++)
+    for (unsigned int x = 0; x < (ARENA_NUM_X - 1); x++)
     {
-        for (unsigned short z = 0; z < (ARENA_NUM_Z - 1); z++)
+        for (unsigned int z = 0; z < (ARENA_NUM_Z - 1); z++)
         {
             // 1---2
             // |   |
             // 0---3
-            unsigned short corners[4] = { (unsigned short)((x * ARENA_NUM_X) + z),
-                                          (unsigned short)((x * ARENA_NUM_X) + z + 1),
-                                          (unsigned short)(((x + 1) * ARENA_NUM_X) + z + 1),
-                                          (unsigned short)(((x + 1) * ARENA_NUM_X) + z )};
+            unsigned int corners[4] = { ((x * ARENA_NUM_X) + z),
+                                        ((x * ARENA_NUM_X) + z + 1),
+                                        (((x + 1) * ARENA_NUM_X) + z + 1),
+                                        (((x + 1) * ARENA_NUM_X) + z )};
 
             // each square consists of two triangular faces:
             // 0,1,3 and 1,2,3
@@ -91,7 +94,7 @@ std::shared_ptr<ObjData3D> createArena()
         }
     }
 
-    if (!arenaObjData->addMesh(md))
+    if (arenaObjData->addMesh(md) == INVALID_MESH_HANDLE)
     {
         arenaObjData = NULL;
     }
@@ -140,7 +143,7 @@ std::shared_ptr<ObjData3D> createLamp()
     md.indices.push_back(1); md.indices.push_back(5); md.indices.push_back(2);
     md.indices.push_back(5); md.indices.push_back(6); md.indices.push_back(2);
 
-    if (!objData->addMesh(md))
+    if (objData->addMesh(md) == INVALID_MESH_HANDLE)
     {
         objData = NULL;
     }
@@ -283,6 +286,12 @@ int main(void)
         return -1;
     }
 
+    // sin and cos of every way a bike can face
+    Heading::setup();
+
+    // every spiral a light trail can make
+    LightTrailSpiralTable::setup();
+
     // load default font
     std::shared_ptr<Texture> defaultFont = Texture::getOrCreate(std::string("textures/compressed/Holstein.DDS"));
     if (!defaultFont)
@@ -329,14 +338,18 @@ int main(void)
     }
 
     // get the lowest point of the bike, so we can move it so the wheels rest on the floor
-    // and the most forward point, so we can use it for collision detection
+    // and the most forward, left and right points, so we can use them for collision detection
     BoundingBox<glm::vec3> bikeBB = bikeLoader->getBoundingBox();
     float bike_lowest = FLT_MAX;
     float bike_most_forward = FLT_MAX;
+    float bike_most_left = FLT_MAX;
+    float bike_most_right = -FLT_MAX;
     for (unsigned int i = 0; i < 8; i++)
     {
         if (bikeBB.vertices[i].y < bike_lowest)       bike_lowest =       bikeBB.vertices[i].y;
         if (bikeBB.vertices[i].z < bike_most_forward) bike_most_forward = bikeBB.vertices[i].z;
+        if (bikeBB.vertices[i].x < bike_most_left)    bike_most_left =    bikeBB.vertices[i].x;
+        if (bikeBB.vertices[i].x > bike_most_right)   bike_most_right =   bikeBB.vertices[i].x;
     }
 
     // we are scaling the bike by 1/2, so update bounding box
@@ -344,13 +357,24 @@ int main(void)
     const float BIKE_SCALE_FACTOR = 0.5f;
     bike_lowest *= BIKE_SCALE_FACTOR;
     bike_most_forward *= BIKE_SCALE_FACTOR;
+    bike_most_left *= BIKE_SCALE_FACTOR;
+    bike_most_right *= BIKE_SCALE_FACTOR;
+
+    // points across the front of the bike that we check for collisions
+    const unsigned int NUM_BIKE_PROBES = 3;
+    const glm::vec3 bikeProbePoints[NUM_BIKE_PROBES] =
+    {
+        glm::vec3(bike_most_left,  0, bike_most_forward),
+        glm::vec3(0,               0, bike_most_forward),
+        glm::vec3(bike_most_right, 0, bike_most_forward),
+    };
 
     // model matrix = model -> world
     glm::mat4 bike_model = glm::translate(glm::vec3(0.0f, -bike_lowest, 0.0f)) *
                            glm::scale(glm::vec3(BIKE_SCALE_FACTOR, BIKE_SCALE_FACTOR, BIKE_SCALE_FACTOR));
 
     // Load bike
-    std::shared_ptr<Bike> bike = std::make_shared<Bike>(bikeLoader, world, Shader::getShader(SHADER_TYPE_MAIN_GEOMETRY_PASS), Shader::getShader(SHADER_TYPE_EXPLODE_GEOMETRY_PASS), bike_model, tronBlue);
+    std::shared_ptr<Bike> bike = std::make_shared<Bike>(bikeLoader, world, Shader::getShader(SHADER_TYPE_MAIN_GEOMETRY_PASS), Shader::getShader(SHADER_TYPE_EXPLODE_GEOMETRY_PASS), Shader::getShader(SHADER_TYPE_LIGHT_TRAIL_GEOMETRY_PASS), bike_model, tronBlue);
     renderPipeline.add3DObject(bike);
 
     // create arena
@@ -400,6 +424,8 @@ int main(void)
     unsigned int frameRate = 0;
     double timeSpentBusy = 0;
     unsigned int displayedMaxPossibleFrameRate = 0;
+    unsigned int displayedUniformWrites = 0;
+    unsigned int displayedUniformWritesSkipped = 0;
 
     // frame rate limiting
     const double maxFrameRatelimit = 60.0;
@@ -426,6 +452,16 @@ int main(void)
 
     // misc
     float lastSpeed = 0.0f;
+    MeshHandle speedBarMesh = INVALID_MESH_HANDLE;
+
+    // where the front of the bike was last frame, for swept collision detection
+    glm::vec3 lastBikeProbeLocations[NUM_BIKE_PROBES];
+    for (unsigned int i = 0; i < NUM_BIKE_PROBES; i++)
+    {
+        lastBikeProbeLocations[i] = bike->applyModelMatrx(bikeProbePoints[i]);
+    }
+    LightTrailProbes bikeProbes;
+    float bikeProbeTimesOfImpact[NUM_BIKE_PROBES];
 
     // debug stuff
     bool stop = false;                          // stop moving the bike with the 's' key
@@ -460,6 +496,11 @@ int main(void)
             // so max possible frame rate would be 1 / that, so just swap the order
             displayedMaxPossibleFrameRate = (unsigned int)(frameCount / timeSpentBusy);
 
+            // and how many uniforms a frame sends, and how many of those were already set
+            displayedUniformWrites = Shader::getUniformWrites() / frameCount;
+            displayedUniformWritesSkipped = Shader::getUniformWritesSkipped() / frameCount;
+            Shader::resetUniformCounters();
+
             timeSpentBusy = 0;
             frameCount = 0;
         }
@@ -585,6 +626,11 @@ int main(void)
         {
             f9KeyPressed = 0;
             bike->restoreBikeState();
+            // we've jumped, so don't check for collisions on the way there
+            for (unsigned int i = 0; i < NUM_BIKE_PROBES; i++)
+            {
+                lastBikeProbeLocations[i] = bike->applyModelMatrx(bikeProbePoints[i]);
+            }
             if (stateIsSaved)
             {
                 cameraRotationDegrees = savedCameraRotationDegrees;
@@ -638,11 +684,20 @@ int main(void)
         // check for collisions
         // only with it's own trail ATM, as there are no more
 
-        // transform co-ords of front of bike to world co-ords.
-        glm::vec3 bikeFrontLocation = bike->applyModelMatrx(glm::vec3(0,0,bike_most_forward));
+        // check the whole path each point on the front of the bike took
+        // this frame, so we can't pass through a light trail between frames
+        bikeProbes.clear();
+        for (unsigned int i = 0; i < NUM_BIKE_PROBES; i++)
+        {
+            // transform co-ords of the point to world co-ords.
+            glm::vec3 probeLocation = bike->applyModelMatrx(bikeProbePoints[i]);
+            bikeProbes.add(glm::vec2(lastBikeProbeLocations[i].x, lastBikeProbeLocations[i].z),
+                           glm::vec2(probeLocation.x, probeLocation.z));
+            lastBikeProbeLocations[i] = probeLocation;
+        }
 
         std::shared_ptr<const LightTrailManager> tm = bike->getTrailManager();
-        if (tm->collides(glm::vec2(bikeFrontLocation.x, bikeFrontLocation.z)) ||
+        if (tm->collides(bikeProbes, bikeProbeTimesOfImpact) ||
             bike->checkSelfCollision())
         {
             bike->setExploding();
@@ -686,8 +741,8 @@ int main(void)
         {
             lastSpeed = speedPercent;
             float end_x = SPEED_BAR_START_X + (SPEED_BAR_END_X - SPEED_BAR_START_X) * speedPercent;
-            speedBar->deleteObjData("speed_bar");
-            speedBar->addRect(glm::vec2(SPEED_BAR_START_X,578), glm::vec2(end_x,578), glm::vec2(end_x,562), glm::vec2(SPEED_BAR_START_X,562),
+            speedBar->deleteObjData(speedBarMesh);
+            speedBarMesh = speedBar->addRect(glm::vec2(SPEED_BAR_START_X,578), glm::vec2(end_x,578), glm::vec2(end_x,562), glm::vec2(SPEED_BAR_START_X,562),
                               glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(speedPercent, 1.0f - speedPercent, 0.0f), glm::vec3(speedPercent, 1.0f - speedPercent, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f),
                               "speed_bar");
         }
@@ -703,6 +758,9 @@ int main(void)
 
             snprintf(textBuff, 32, "      (MAX): %d", displayedMaxPossibleFrameRate);
             text->addText2D(textBuff, 10, 530, 26, defaultFont);
+
+            snprintf(textBuff, 32, "Uniforms: %u (%u skipped)", displayedUniformWrites, displayedUniformWritesSkipped);
+            text->addText2D(textBuff, 10, 470, 26, defaultFont);
         }
 
 #ifdef DEBUG_ALLOW_SELECTING_ACTIVE_LIGHT_TRAIL_SEGMENT
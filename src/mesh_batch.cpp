@@ -0,0 +1,138 @@
+#include "mesh_batch.hpp"
+#include "shader.hpp"
+#include "texture.hpp"
+
+#include <algorithm>
+#include <stdio.h>
+
+MeshBatch::MeshBatch()
+{
+}
+
+MeshBatch::~MeshBatch()
+{
+}
+
+unsigned int MeshBatch::addGroup(const std::vector<unsigned int> &meshIndexes)
+{
+    groupMeshIndexes.push_back(meshIndexes);
+    return groupMeshIndexes.size() - 1;
+}
+
+// what we sort and group meshes by, 0 for ones without a texture
+static GLuint textureID(const std::shared_ptr<Texture> &texture)
+{
+    return texture ? texture->getTextureID() : 0;
+}
+
+bool MeshBatch::build(const ObjData3D &objData)
+{
+    const std::vector<std::shared_ptr<Mesh<glm::vec3>>> &meshes = objData.getMeshes();
+
+    MeshData<glm::vec3> md;
+    md.name = "batch";
+    md.hasTexture = true;
+    md.needsUpdate = false;
+
+    groups.clear();
+    groups.resize(groupMeshIndexes.size());
+    for (unsigned int g = 0; g < groupMeshIndexes.size(); g++)
+    {
+        // sort the group by texture, so each texture is only bound once.
+        // layers of the same texture array count as the same texture
+        std::vector<unsigned int> sorted = groupMeshIndexes[g];
+        std::stable_sort(sorted.begin(), sorted.end(),
+                         [&](unsigned int a, unsigned int b)
+                         {
+                             return textureID(meshes[a]->texture) < textureID(meshes[b]->texture);
+                         });
+
+        for (auto i : sorted)
+        {
+            const MeshData<glm::vec3> *meshData = objData.getMeshData(objData.getMeshHandle(i));
+            const std::shared_ptr<Texture> &texture = meshes[i]->texture;
+            if (groups[g].empty() || textureID(groups[g].back().texture) != textureID(texture))
+            {
+                groups[g].push_back(Draw());
+                groups[g].back().texture = texture;
+            }
+
+            // indices stay relative to the mesh's first vertex, and the offset
+            // is in indices until we know what size they are
+            Draw &draw = groups[g].back();
+            draw.counts.push_back(meshData->indices.size());
+            draw.offsets.push_back((const void *)md.indices.size());
+            draw.baseVertices.push_back(md.vertices.size());
+
+            md.indices.insert(md.indices.end(), meshData->indices.begin(), meshData->indices.end());
+            md.vertices.insert(md.vertices.end(), meshData->vertices.begin(), meshData->vertices.end());
+            md.normals.insert(md.normals.end(), meshData->normals.begin(), meshData->normals.end());
+            if (meshData->hasTexture)
+            {
+                md.uvs.insert(md.uvs.end(), meshData->uvs.begin(), meshData->uvs.end());
+            }
+            float layer = (texture && texture->isArrayLayer()) ? (float)texture->getLayer() : -1.0f;
+            md.textureLayers.resize(md.vertices.size(), layer);
+
+            // keep everything lined up for meshes that are missing some
+            md.normals.resize(md.vertices.size());
+            md.uvs.resize(md.vertices.size());
+        }
+    }
+
+    if (md.vertices.empty())
+    {
+        printf("nothing to batch\n");
+        return false;
+    }
+
+    batchData = std::make_unique<ObjData3D>();
+    batchData->useInterleavedVertices();
+    if (batchData->addMesh(std::move(md)) == INVALID_MESH_HANDLE)
+    {
+        printf("unable to create batch buffers\n");
+        batchData = NULL;
+        return false;
+    }
+
+    unsigned int indexSize = (batchData->getMeshes()[0]->indexType == GL_UNSIGNED_SHORT) ? sizeof(GLushort) : sizeof(GLuint);
+    for (auto &group : groups)
+    {
+        for (auto &draw : group)
+        {
+            for (auto &offset : draw.offsets)
+            {
+                offset = (const void *)((size_t)offset * indexSize);
+            }
+        }
+    }
+    return true;
+}
+
+void MeshBatch::drawGroup(unsigned int group, const Shader &shader, const glm::vec3 &defaultColour) const
+{
+    if (!batchData || group >= groups.size())
+    {
+        return;
+    }
+
+    const std::shared_ptr<Mesh<glm::vec3>> &mesh = batchData->getMeshes()[0];
+    mesh->bindVertexArray(shader);
+
+    for (auto &draw : groups[group])
+    {
+        if (draw.texture)
+        {
+            draw.texture->bind(shader);
+            shader.setUniform(SHADER_UNIFORM_IS_TEXTURE, 1.0f);
+        }
+        else
+        {
+            shader.setUniform(SHADER_UNIFORM_FRAGMENT_COLOUR, defaultColour);
+            shader.setUniform(SHADER_UNIFORM_IS_TEXTURE, 0.0f);
+        }
+
+        glMultiDrawElementsBaseVertex(GL_TRIANGLES, &draw.counts[0], mesh->indexType,
+                                      &draw.offsets[0], draw.counts.size(), &draw.baseVertices[0]);
+    }
+}
@@ -0,0 +1,53 @@
+#ifndef __MESH_BATCH_HPP
+#define __MESH_BATCH_HPP
+
+#include "object_data.hpp"
+
+#include <memory>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include <GL/glew.h>
+
+class Shader;
+class Texture;
+
+// meshes from an ObjData3D copied into one vertex buffer and one index buffer,
+// so a group of them can be drawn with a glMultiDrawElementsBaseVertex for each
+// texture in the group, rather than a draw for each mesh.
+// the meshes are copied, so the ObjData3D shouldn't change afterwards
+class MeshBatch
+{
+public:
+    MeshBatch();
+    ~MeshBatch();
+
+    // meshIndexes are indexes into the ObjData3D's getMeshes(), that are always drawn
+    // together with the same model matrix. returns the group to pass to drawGroup()
+    unsigned int addGroup(const std::vector<unsigned int> &meshIndexes);
+
+    // copy every group's meshes into the buffers, call once all the groups are added
+    bool build(const ObjData3D &objData);
+
+    // shader should be in use with the MVP sent. meshes without textures are defaultColour
+    void drawGroup(unsigned int group, const Shader &shader, const glm::vec3 &defaultColour) const;
+
+protected:
+    // the meshes in a group that have the same texture, or layers of the same texture array
+    struct Draw
+    {
+        std::shared_ptr<Texture> texture;   // the first mesh's, NULL for meshes without one
+        std::vector<GLsizei> counts;
+        std::vector<const void *> offsets;
+        std::vector<GLint> baseVertices;
+    };
+
+    std::vector<std::vector<unsigned int>> groupMeshIndexes;
+    std::vector<std::vector<Draw>> groups;
+
+    // every mesh one after the other in a single mesh
+    std::unique_ptr<ObjData3D> batchData;
+};
+
+#endif
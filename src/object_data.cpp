@@ -1,10 +1,128 @@
 #include "object_data.hpp"
 #include "texture.hpp"
+#include "shader.hpp"
 
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstring>
+
+// when a buffer is too small we at least double it, so
+// meshes that grow a bit every frame don't reallocate every frame
+#define BUFFER_GROWTH_FACTOR    2
+
+// 16 bit indices can only reach vertices 0 to 65535
+#define MAX_VERTICES_FOR_SHORT_INDICES  65536
+
+// room left around packed positions, so meshes that grow a bit don't have to be repacked
+#define PACKED_POSITION_MARGIN  1.0f
+
+template struct Mesh<glm::vec2>;
+template struct Mesh<glm::vec3>;
 template class ObjData<glm::vec2>;
 template class ObjData<glm::vec3>;
 
-template<typename T> ObjData<T>::ObjData()
+// the shader uses attribute id if it has a location for it
+static bool hasAttrib(const Shader &shader, ShaderAttribID id)
+{
+    return shader.getAttribID(id) != (GLuint)-1;
+}
+
+template<typename T> void Mesh<T>::bindVertexArray(const Shader &shader)
+{
+    for (auto &va : vertexArrays)
+    {
+        if (va.first == &shader)
+        {
+            glBindVertexArray(va.second);
+            return;
+        }
+    }
+
+    // first time we've been drawn with this shader, so hook up
+    // every buffer we have that the shader has an attribute for
+    GLuint vertexArray;
+    glGenVertexArrays(1, &vertexArray);
+    glBindVertexArray(vertexArray);
+
+    GLint numComponents = sizeof(T) / sizeof(float);
+    glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+    if (packed)
+    {
+        // positions and normals are together, see ObjData::usePackedVertices()
+        GLsizei stride = packedVertexSize<T>();
+        if (hasAttrib(shader, SHADER_ATTRIB_VERTEX_POS))
+        {
+            glEnableVertexAttribArray(shader.getAttribID(SHADER_ATTRIB_VERTEX_POS));
+            glVertexAttribPointer(shader.getAttribID(SHADER_ATTRIB_VERTEX_POS), numComponents, GL_UNSIGNED_SHORT, GL_TRUE, stride, (void *)0);
+        }
+        if (hasAttrib(shader, SHADER_ATTRIB_VERTEX_NORMAL))
+        {
+            glEnableVertexAttribArray(shader.getAttribID(SHADER_ATTRIB_VERTEX_NORMAL));
+            glVertexAttribPointer(shader.getAttribID(SHADER_ATTRIB_VERTEX_NORMAL), 4, GL_INT_2_10_10_10_REV, GL_TRUE, stride, (const void *)(size_t)packedPositionSize<T>());
+        }
+    }
+    else if (interleaved)
+    {
+        // everything's in vertexBuffer, see ObjData::useInterleavedVertices()
+        if (hasAttrib(shader, SHADER_ATTRIB_VERTEX_POS))
+        {
+            glEnableVertexAttribArray(shader.getAttribID(SHADER_ATTRIB_VERTEX_POS));
+            glVertexAttribPointer(shader.getAttribID(SHADER_ATTRIB_VERTEX_POS), numComponents, GL_FLOAT, GL_FALSE, vertexStride, (void *)0);
+        }
+        if (normalOffset && hasAttrib(shader, SHADER_ATTRIB_VERTEX_NORMAL))
+        {
+            glEnableVertexAttribArray(shader.getAttribID(SHADER_ATTRIB_VERTEX_NORMAL));
+            glVertexAttribPointer(shader.getAttribID(SHADER_ATTRIB_VERTEX_NORMAL), numComponents, GL_FLOAT, GL_FALSE, vertexStride, (const void *)(size_t)normalOffset);
+        }
+        if (uvOffset && hasAttrib(shader, SHADER_ATTRIB_VERTEX_UV))
+        {
+            glEnableVertexAttribArray(shader.getAttribID(SHADER_ATTRIB_VERTEX_UV));
+            glVertexAttribPointer(shader.getAttribID(SHADER_ATTRIB_VERTEX_UV), 2, GL_FLOAT, GL_FALSE, vertexStride, (const void *)(size_t)uvOffset);
+        }
+        if (colourOffset && hasAttrib(shader, SHADER_ATTRIB_VERTEX_COLOUR))
+        {
+            glEnableVertexAttribArray(shader.getAttribID(SHADER_ATTRIB_VERTEX_COLOUR));
+            glVertexAttribPointer(shader.getAttribID(SHADER_ATTRIB_VERTEX_COLOUR), 3, GL_FLOAT, GL_FALSE, vertexStride, (const void *)(size_t)colourOffset);
+        }
+        if (textureLayerOffset && hasAttrib(shader, SHADER_ATTRIB_VERTEX_TEXTURE_LAYER))
+        {
+            glEnableVertexAttribArray(shader.getAttribID(SHADER_ATTRIB_VERTEX_TEXTURE_LAYER));
+            glVertexAttribPointer(shader.getAttribID(SHADER_ATTRIB_VERTEX_TEXTURE_LAYER), 1, GL_FLOAT, GL_FALSE, vertexStride, (const void *)(size_t)textureLayerOffset);
+        }
+    }
+    else
+    {
+        if (hasAttrib(shader, SHADER_ATTRIB_VERTEX_POS))
+        {
+            glEnableVertexAttribArray(shader.getAttribID(SHADER_ATTRIB_VERTEX_POS));
+            glVertexAttribPointer(shader.getAttribID(SHADER_ATTRIB_VERTEX_POS), numComponents, GL_FLOAT, GL_FALSE, 0, (void *)0);
+        }
+        if (normalBuffer && hasAttrib(shader, SHADER_ATTRIB_VERTEX_NORMAL))
+        {
+            glBindBuffer(GL_ARRAY_BUFFER, normalBuffer);
+            glEnableVertexAttribArray(shader.getAttribID(SHADER_ATTRIB_VERTEX_NORMAL));
+            glVertexAttribPointer(shader.getAttribID(SHADER_ATTRIB_VERTEX_NORMAL), numComponents, GL_FLOAT, GL_FALSE, 0, (void *)0);
+        }
+        if (hasTexture && hasAttrib(shader, SHADER_ATTRIB_VERTEX_UV))
+        {
+            glBindBuffer(GL_ARRAY_BUFFER, uvBuffer);
+            glEnableVertexAttribArray(shader.getAttribID(SHADER_ATTRIB_VERTEX_UV));
+            glVertexAttribPointer(shader.getAttribID(SHADER_ATTRIB_VERTEX_UV), 2, GL_FLOAT, GL_FALSE, 0, (void *)0);
+        }
+        if (colourBuffer && hasAttrib(shader, SHADER_ATTRIB_VERTEX_COLOUR))
+        {
+            glBindBuffer(GL_ARRAY_BUFFER, colourBuffer);
+            glEnableVertexAttribArray(shader.getAttribID(SHADER_ATTRIB_VERTEX_COLOUR));
+            glVertexAttribPointer(shader.getAttribID(SHADER_ATTRIB_VERTEX_COLOUR), 3, GL_FLOAT, GL_FALSE, 0, (void *)0);
+        }
+    }
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indiceBuffer);
+
+    vertexArrays.push_back(std::make_pair(&shader, vertexArray));
+}
+
+template<typename T> ObjData<T>::ObjData() : packedVertices(false), interleavedVertices(false)
 {
 }
 
@@ -12,47 +130,210 @@ template<typename T> ObjData<T>::~ObjData()
 {
 }
 
-template<typename T> bool ObjData<T>::addMesh(const MeshData<T> &md)
+template<typename T> MeshHandle ObjData<T>::addMesh(const MeshData<T> &md)
 {
     meshData.push_back(md);
+    return addLastMesh();
+}
+
+template<typename T> MeshHandle ObjData<T>::addMesh(MeshData<T> &&md)
+{
+    meshData.push_back(std::move(md));
+    return addLastMesh();
+}
+
+// make the buffers for the last thing in meshData and give it a handle
+template<typename T> MeshHandle ObjData<T>::addLastMesh()
+{
     boundingBoxIsCached = false;
-    return createBuffers(meshData.back());
+    if (!createBuffers(meshData.back()))
+    {
+        meshData.pop_back();
+        return INVALID_MESH_HANDLE;
+    }
+
+    MeshHandle handle;
+    if (freeHandles.size())
+    {
+        handle = freeHandles.back();
+        freeHandles.pop_back();
+    }
+    else
+    {
+        handle = handleIndexes.size();
+        handleIndexes.push_back(INVALID_MESH_HANDLE);
+    }
+    handleIndexes[handle] = meshData.size() - 1;
+    meshHandles.push_back(handle);
+    return handle;
 }
 
-template<typename T> bool ObjData<T>::updateMesh(const MeshData<T> &data)
+// widen begin and end to cover everything that's different between
+// oldData and newData. anything past the end of oldData is different
+template<typename V> static void growDirtyRange(const std::vector<V> &oldData, const std::vector<V> &newData,
+                                                unsigned int &begin, unsigned int &end)
 {
-    for (auto &md : meshData)
+    unsigned int oldSize = oldData.size();
+    unsigned int newSize = newData.size();
+
+    unsigned int first = 0;
+    unsigned int common = std::min(oldSize, newSize);
+    while (first < common && oldData[first] == newData[first])
     {
-        if (md.name.compare(data.name) == 0)
+        first++;
+    }
+
+    unsigned int last = newSize;
+    if (newSize <= oldSize)
+    {
+        while (last > first && oldData[last - 1] == newData[last - 1])
         {
-            md = data;
-            md.needsUpdate = true;
-            boundingBoxIsCached = false;
-            return true;
+            last--;
         }
     }
-    return false;
+
+    if (first < last)
+    {
+        begin = std::min(begin, first);
+        end = std::max(end, last);
+    }
 }
 
-template<typename T> void ObjData<T>::deleteMesh(const std::string &name)
+template<typename T> unsigned int ObjData<T>::getIndex(MeshHandle handle) const
 {
-    for (auto it = meshData.begin(); it != meshData.end(); it++)
+    if (handle >= handleIndexes.size())
     {
-        if (it->name.compare(name) == 0)
-        {
-            meshData.erase(it);
-            break;
-        }
+        return INVALID_MESH_HANDLE;
     }
+    return handleIndexes[handle];
+}
+
+template<typename T> void ObjData<T>::findChanges(unsigned int index, const MeshData<T> &data)
+{
+    MeshData<T> &md = meshData[index];
+    Mesh<T> *m = meshes[index].get();
+
+    // work out what's changed, adding to anything that
+    // changed before that we haven't uploaded yet
+    growDirtyRange(md.vertices, data.vertices, m->dirtyVerticesBegin, m->dirtyVerticesEnd);
+    growDirtyRange(md.normals, data.normals, m->dirtyVerticesBegin, m->dirtyVerticesEnd);
+    if (data.hasTexture)
+    {
+        growDirtyRange(md.uvs, data.uvs, m->dirtyVerticesBegin, m->dirtyVerticesEnd);
+    }
+    growDirtyRange(md.colours, data.colours, m->dirtyVerticesBegin, m->dirtyVerticesEnd);
+    growDirtyRange(md.textureLayers, data.textureLayers, m->dirtyVerticesBegin, m->dirtyVerticesEnd);
+    growDirtyRange(md.indices, data.indices, m->dirtyIndicesBegin, m->dirtyIndicesEnd);
+
+    boundingBoxIsCached = false;
+}
+
+template<typename T> bool ObjData<T>::updateMesh(MeshHandle handle, const MeshData<T> &data)
+{
+    unsigned int index = getIndex(handle);
+    if (index == INVALID_MESH_HANDLE)
+    {
+        return false;
+    }
+    findChanges(index, data);
+    meshData[index] = data;
+    meshData[index].needsUpdate = true;
+    return true;
+}
 
-    for (auto it = meshes.begin(); it != meshes.end(); it++)
+template<typename T> bool ObjData<T>::updateMesh(MeshHandle handle, MeshData<T> &&data)
+{
+    unsigned int index = getIndex(handle);
+    if (index == INVALID_MESH_HANDLE)
     {
-        if ((*it)->name.compare(name) == 0)
+        return false;
+    }
+    findChanges(index, data);
+    meshData[index] = std::move(data);
+    meshData[index].needsUpdate = true;
+    return true;
+}
+
+template<typename T> MeshData<T> *ObjData<T>::getMeshData(MeshHandle handle)
+{
+    unsigned int index = getIndex(handle);
+    if (index == INVALID_MESH_HANDLE)
+    {
+        return NULL;
+    }
+    return &meshData[index];
+}
+
+template<typename T> const MeshData<T> *ObjData<T>::getMeshData(MeshHandle handle) const
+{
+    unsigned int index = getIndex(handle);
+    if (index == INVALID_MESH_HANDLE)
+    {
+        return NULL;
+    }
+    return &meshData[index];
+}
+
+template<typename T> void ObjData<T>::markDirty(MeshHandle handle,
+                                                unsigned int verticesBegin, unsigned int verticesEnd,
+                                                unsigned int indicesBegin, unsigned int indicesEnd)
+{
+    unsigned int index = getIndex(handle);
+    if (index == INVALID_MESH_HANDLE)
+    {
+        return;
+    }
+
+    Mesh<T> *m = meshes[index].get();
+    if (verticesBegin < verticesEnd)
+    {
+        m->dirtyVerticesBegin = std::min(m->dirtyVerticesBegin, verticesBegin);
+        m->dirtyVerticesEnd = std::max(m->dirtyVerticesEnd, verticesEnd);
+    }
+    if (indicesBegin < indicesEnd)
+    {
+        m->dirtyIndicesBegin = std::min(m->dirtyIndicesBegin, indicesBegin);
+        m->dirtyIndicesEnd = std::max(m->dirtyIndicesEnd, indicesEnd);
+    }
+    meshData[index].needsUpdate = true;
+    boundingBoxIsCached = false;
+}
+
+template<typename T> MeshHandle ObjData<T>::findMesh(const std::string &name) const
+{
+    for (unsigned int i = 0; i < meshData.size(); i++)
+    {
+        if (meshData[i].name.compare(name) == 0)
         {
-            meshes.erase(it);
-            break;
+            return meshHandles[i];
         }
     }
+    return INVALID_MESH_HANDLE;
+}
+
+template<typename T> void ObjData<T>::deleteMesh(MeshHandle handle)
+{
+    unsigned int index = getIndex(handle);
+    if (index == INVALID_MESH_HANDLE)
+    {
+        return;
+    }
+
+    // move the last mesh into the gap, so nothing else has to move
+    unsigned int last = meshData.size() - 1;
+    if (index != last)
+    {
+        meshData[index] = std::move(meshData[last]);
+        meshes[index] = std::move(meshes[last]);
+        meshHandles[index] = meshHandles[last];
+        handleIndexes[meshHandles[index]] = index;
+    }
+    meshData.pop_back();
+    meshes.pop_back();
+    meshHandles.pop_back();
+
+    handleIndexes[handle] = INVALID_MESH_HANDLE;
+    freeHandles.push_back(handle);
     boundingBoxIsCached = false;
 }
 
@@ -60,10 +341,176 @@ template<typename T> void ObjData<T>::deleteAll()
 {
     meshData.clear();
     meshes.clear();
+    meshHandles.clear();
+    handleIndexes.clear();
+    freeHandles.clear();
 
     boundingBoxIsCached = false;
 }
 
+static GLenum chooseIndexType(unsigned int numVertices)
+{
+    return (numVertices <= MAX_VERTICES_FOR_SHORT_INDICES) ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+}
+
+static unsigned int indexSize(GLenum indexType)
+{
+    return (indexType == GL_UNSIGNED_SHORT) ? sizeof(GLushort) : sizeof(GLuint);
+}
+
+// indices begin to end, ready to go into a buffer of indexType.
+// 16 bit ones are converted into a scratch vector, which is only
+// valid until the next call
+static const void *indicesAs(GLenum indexType, const std::vector<unsigned int> &indices, unsigned int begin, unsigned int end)
+{
+    static std::vector<GLushort> shortIndices;
+
+    if (begin >= end)
+    {
+        return NULL;
+    }
+    if (indexType == GL_UNSIGNED_INT)
+    {
+        return &indices[begin];
+    }
+    shortIndices.assign(indices.begin() + begin, indices.begin() + end);
+    return &shortIndices[0];
+}
+
+// set the range positions are packed into to cover all of md's vertices, and margin more either side
+template<typename T> static void choosePackingRange(const MeshData<T> &md, float margin, Mesh<T> &m)
+{
+    T min = md.vertices[0];
+    T max = md.vertices[0];
+    for (auto &v : md.vertices)
+    {
+        min = glm::min(min, v);
+        max = glm::max(max, v);
+    }
+    m.positionOrigin = min - T(margin);
+    m.positionScale = (max - min) + T(2.0f * margin);
+}
+
+template<typename T> static bool fitsPackingRange(const MeshData<T> &md, const Mesh<T> &m, unsigned int begin, unsigned int end)
+{
+    T max = m.positionOrigin + m.positionScale;
+    for (unsigned int i = begin; i < end; i++)
+    {
+        if (glm::any(glm::lessThan(md.vertices[i], m.positionOrigin)) ||
+            glm::any(glm::greaterThan(md.vertices[i], max)))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+static GLuint packNormalComponent(float n)
+{
+    // 10 bit signed, -511 to 511
+    int packed = (int)floorf(glm::clamp(n, -1.0f, 1.0f) * 511.0f + 0.5f);
+    return (GLuint)packed & 0x3ff;
+}
+
+static GLuint packNormal(const glm::vec2 &n)
+{
+    return packNormalComponent(n.x) | (packNormalComponent(n.y) << 10);
+}
+
+static GLuint packNormal(const glm::vec3 &n)
+{
+    return packNormalComponent(n.x) | (packNormalComponent(n.y) << 10) | (packNormalComponent(n.z) << 20);
+}
+
+// vertices begin to end of md packed for m's buffer, into a scratch
+// vector which is only valid until the next call
+template<typename T> static const std::vector<char> &packVertices(const MeshData<T> &md, const Mesh<T> &m,
+                                                                  unsigned int begin, unsigned int end)
+{
+    static std::vector<char> packed;
+
+    unsigned int numComponents = sizeof(T) / sizeof(float);
+    unsigned int vertexSize = packedVertexSize<T>();
+    packed.assign((end - begin) * vertexSize, 0);
+    for (unsigned int i = begin; i < end; i++)
+    {
+        char *vertex = &packed[(i - begin) * vertexSize];
+        GLushort *position = (GLushort *)vertex;
+        for (unsigned int c = 0; c < numComponents; c++)
+        {
+            float t = (md.vertices[i][c] - m.positionOrigin[c]) / m.positionScale[c];
+            position[c] = (GLushort)floorf(glm::clamp(t, 0.0f, 1.0f) * 65535.0f + 0.5f);
+        }
+        GLuint normal = (i < md.normals.size()) ? packNormal(md.normals[i]) : 0;
+        memcpy(vertex + packedPositionSize<T>(), &normal, sizeof(normal));
+    }
+    return packed;
+}
+
+// work out where each part of md's vertices goes in m's interleaved buffer
+template<typename T> static void chooseInterleavedLayout(const MeshData<T> &md, Mesh<T> &m)
+{
+    unsigned int offset = sizeof(T);
+
+    m.normalOffset = 0;
+    if (md.normals.size())
+    {
+        m.normalOffset = offset;
+        offset += sizeof(T);
+    }
+    m.uvOffset = 0;
+    if (md.hasTexture)
+    {
+        m.uvOffset = offset;
+        offset += sizeof(glm::vec2);
+    }
+    m.colourOffset = 0;
+    if (md.colours.size())
+    {
+        m.colourOffset = offset;
+        offset += sizeof(glm::vec3);
+    }
+    m.textureLayerOffset = 0;
+    if (md.textureLayers.size())
+    {
+        m.textureLayerOffset = offset;
+        offset += sizeof(float);
+    }
+    m.vertexStride = offset;
+}
+
+// vertices begin to end of md interleaved for m's buffer, into a scratch
+// vector which is only valid until the next call
+template<typename T> static const std::vector<char> &interleaveVertices(const MeshData<T> &md, const Mesh<T> &m,
+                                                                        unsigned int begin, unsigned int end)
+{
+    static std::vector<char> interleaved;
+
+    interleaved.assign((end - begin) * m.vertexStride, 0);
+    for (unsigned int i = begin; i < end; i++)
+    {
+        char *vertex = &interleaved[(i - begin) * m.vertexStride];
+        memcpy(vertex, &md.vertices[i], sizeof(T));
+        if (m.normalOffset && i < md.normals.size())
+        {
+            memcpy(vertex + m.normalOffset, &md.normals[i], sizeof(T));
+        }
+        if (m.uvOffset && i < md.uvs.size())
+        {
+            memcpy(vertex + m.uvOffset, &md.uvs[i], sizeof(glm::vec2));
+        }
+        if (m.colourOffset && i < md.colours.size())
+        {
+            memcpy(vertex + m.colourOffset, &md.colours[i], sizeof(glm::vec3));
+        }
+        if (m.textureLayerOffset && i < md.textureLayers.size())
+        {
+            memcpy(vertex + m.textureLayerOffset, &md.textureLayers[i], sizeof(float));
+        }
+    }
+    return interleaved;
+}
+
 template<typename T> bool ObjData<T>::createBuffers(MeshData<T> &md)
 {
     std::shared_ptr<Mesh<T>> newMesh = std::make_shared<Mesh<T>>();
@@ -71,24 +518,55 @@ template<typename T> bool ObjData<T>::createBuffers(MeshData<T> &md)
     newMesh->name = md.name;
     newMesh->hasTexture = md.hasTexture;
 
+    newMesh->numVertices = md.vertices.size();
     newMesh->numIndices = md.indices.size();
+    newMesh->indexType = chooseIndexType(md.vertices.size());
+    newMesh->vertexCapacity = md.vertices.size();
+    newMesh->indexCapacity = md.indices.size();
+    newMesh->dirtyVerticesBegin = UINT_MAX;
+    newMesh->dirtyVerticesEnd = 0;
+    newMesh->dirtyIndicesBegin = UINT_MAX;
+    newMesh->dirtyIndicesEnd = 0;
 
     newMesh->firstVertex = md.vertices[0];
+    newMesh->packed = packedVertices;
+    newMesh->interleaved = interleavedVertices && !packedVertices;
+    if (newMesh->interleaved)
+    {
+        chooseInterleavedLayout(md, *newMesh);
+    }
 
     // generate buffers
     glGenBuffers(1, &newMesh->vertexBuffer);
     glBindBuffer(GL_ARRAY_BUFFER, newMesh->vertexBuffer);
-    glBufferData(GL_ARRAY_BUFFER, md.vertices.size() * sizeof(md.vertices[0]), &md.vertices[0], GL_STATIC_DRAW);
+    if (newMesh->packed)
+    {
+        choosePackingRange(md, PACKED_POSITION_MARGIN, *newMesh);
+        const std::vector<char> &packed = packVertices(md, *newMesh, 0, md.vertices.size());
+        glBufferData(GL_ARRAY_BUFFER, packed.size(), &packed[0], GL_STATIC_DRAW);
+    }
+    else if (newMesh->interleaved)
+    {
+        const std::vector<char> &interleaved = interleaveVertices(md, *newMesh, 0, md.vertices.size());
+        glBufferData(GL_ARRAY_BUFFER, interleaved.size(), &interleaved[0], GL_STATIC_DRAW);
+    }
+    else
+    {
+        glBufferData(GL_ARRAY_BUFFER, md.vertices.size() * sizeof(md.vertices[0]), &md.vertices[0], GL_STATIC_DRAW);
+    }
 
-    if (newMesh->hasTexture)
+    // interleaved meshes don't need any of these, everything's in the vertex buffer
+    newMesh->uvBuffer = 0;
+    if (newMesh->hasTexture && !newMesh->interleaved)
     {
         glGenBuffers(1, &newMesh->uvBuffer);
         glBindBuffer(GL_ARRAY_BUFFER, newMesh->uvBuffer);
         glBufferData(GL_ARRAY_BUFFER, md.uvs.size() * sizeof(md.uvs[0]), &md.uvs[0], GL_STATIC_DRAW);;
     }
 
-    // we don't use normals in ObjData2D
-    if (md.normals.size())
+    // we don't use normals in ObjData2D, and packed ones are in the vertex buffer
+    newMesh->normalBuffer = 0;
+    if (md.normals.size() && !newMesh->packed && !newMesh->interleaved)
     {
         glGenBuffers(1, &newMesh->normalBuffer);
         glBindBuffer(GL_ARRAY_BUFFER, newMesh->normalBuffer);
@@ -96,16 +574,20 @@ template<typename T> bool ObjData<T>::createBuffers(MeshData<T> &md)
     }
 
     // we don't have colours in Object3D
-    if (md.colours.size())
+    newMesh->colourBuffer = 0;
+    if (md.colours.size() && !newMesh->interleaved)
     {
         glGenBuffers(1, &newMesh->colourBuffer);
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, newMesh->colourBuffer);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, md.colours.size() * sizeof(md.colours[0]), &md.colours[0], GL_STATIC_DRAW);
+        glBindBuffer(GL_ARRAY_BUFFER, newMesh->colourBuffer);
+        glBufferData(GL_ARRAY_BUFFER, md.colours.size() * sizeof(md.colours[0]), &md.colours[0], GL_STATIC_DRAW);
     }
 
+    // filled through GL_ARRAY_BUFFER, as binding GL_ELEMENT_ARRAY_BUFFER
+    // would change the index buffer of whichever vertex array is bound
     glGenBuffers(1, &newMesh->indiceBuffer);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, newMesh->indiceBuffer);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, md.indices.size() * sizeof(md.indices[0]), &md.indices[0], GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, newMesh->indiceBuffer);
+    glBufferData(GL_ARRAY_BUFFER, md.indices.size() * indexSize(newMesh->indexType),
+                 indicesAs(newMesh->indexType, md.indices, 0, md.indices.size()), GL_STATIC_DRAW);
 
     if (newMesh->hasTexture)
     {
@@ -133,45 +615,207 @@ template<typename T> bool ObjData<T>::createBuffers(MeshData<T> &md)
     return true;
 }
 
+// make buffer big enough for capacity elements, and fill it with data
+template<typename V> static void reallocateBuffer(GLuint buffer, const std::vector<V> &data, unsigned int capacity)
+{
+    glBindBuffer(GL_ARRAY_BUFFER, buffer);
+    glBufferData(GL_ARRAY_BUFFER, capacity * sizeof(V), NULL, GL_DYNAMIC_DRAW);
+    if (data.size())
+    {
+        glBufferSubData(GL_ARRAY_BUFFER, 0, data.size() * sizeof(V), &data[0]);
+    }
+}
+
+// upload elements begin to end of data into buffer
+template<typename V> static void uploadRange(GLuint buffer, const std::vector<V> &data, unsigned int begin, unsigned int end)
+{
+    end = std::min(end, (unsigned int)data.size());
+    if (begin >= end)
+    {
+        return;
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, buffer);
+    glBufferSubData(GL_ARRAY_BUFFER, begin * sizeof(V), (end - begin) * sizeof(V), &data[begin]);
+}
+
+static void reallocateIndices(GLuint buffer, GLenum indexType, const std::vector<unsigned int> &indices, unsigned int capacity)
+{
+    glBindBuffer(GL_ARRAY_BUFFER, buffer);
+    glBufferData(GL_ARRAY_BUFFER, capacity * indexSize(indexType), NULL, GL_DYNAMIC_DRAW);
+    if (indices.size())
+    {
+        glBufferSubData(GL_ARRAY_BUFFER, 0, indices.size() * indexSize(indexType),
+                        indicesAs(indexType, indices, 0, indices.size()));
+    }
+}
+
+static void uploadIndexRange(GLuint buffer, GLenum indexType, const std::vector<unsigned int> &indices, unsigned int begin, unsigned int end)
+{
+    end = std::min(end, (unsigned int)indices.size());
+    if (begin >= end)
+    {
+        return;
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, buffer);
+    glBufferSubData(GL_ARRAY_BUFFER, begin * indexSize(indexType), (end - begin) * indexSize(indexType),
+                    indicesAs(indexType, indices, begin, end));
+}
+
+// bind m's vertex buffer, making it bigger if it can't fit numVertices of vertexSize.
+// returns true if it had to, in which case everything in it is lost
+template<typename T> static bool reserveVertices(Mesh<T> &m, unsigned int numVertices, unsigned int vertexSize)
+{
+    glBindBuffer(GL_ARRAY_BUFFER, m.vertexBuffer);
+    if (numVertices <= m.vertexCapacity)
+    {
+        return false;
+    }
+    m.vertexCapacity = std::max(numVertices, m.vertexCapacity * BUFFER_GROWTH_FACTOR);
+    glBufferData(GL_ARRAY_BUFFER, m.vertexCapacity * vertexSize, NULL, GL_DYNAMIC_DRAW);
+    return true;
+}
+
+template<typename T> static void updatePackedBuffer(const MeshData<T> &md, Mesh<T> &m)
+{
+    unsigned int numVertices = md.vertices.size();
+    unsigned int begin = m.dirtyVerticesBegin;
+    unsigned int end = std::min(m.dirtyVerticesEnd, numVertices);
+
+    // if we're uploading all of it anyway we can fit the range to it again,
+    // otherwise we only change the range when a vertex goes outside it, and then
+    // leave plenty of room, so meshes that keep growing don't get repacked too often
+    bool wholeMesh = (begin == 0 && end == numVertices);
+    if (wholeMesh)
+    {
+        choosePackingRange(md, PACKED_POSITION_MARGIN, m);
+    }
+    else if (!fitsPackingRange(md, m, begin, end))
+    {
+        T size = m.positionScale;
+        float largest = 0.0f;
+        for (unsigned int c = 0; c < sizeof(T) / sizeof(float); c++)
+        {
+            largest = std::max(largest, size[c]);
+        }
+        choosePackingRange(md, std::max(PACKED_POSITION_MARGIN, largest / 2.0f), m);
+        begin = 0;
+        end = numVertices;
+    }
+
+    unsigned int vertexSize = packedVertexSize<T>();
+    if (reserveVertices(m, numVertices, vertexSize))
+    {
+        begin = 0;
+        end = numVertices;
+    }
+    if (begin < end)
+    {
+        const std::vector<char> &packed = packVertices(md, m, begin, end);
+        glBufferSubData(GL_ARRAY_BUFFER, begin * vertexSize, packed.size(), &packed[0]);
+    }
+}
+
+template<typename T> static void updateInterleavedBuffer(const MeshData<T> &md, Mesh<T> &m)
+{
+    unsigned int numVertices = md.vertices.size();
+    unsigned int begin = m.dirtyVerticesBegin;
+    unsigned int end = std::min(m.dirtyVerticesEnd, numVertices);
+
+    if (reserveVertices(m, numVertices, m.vertexStride))
+    {
+        begin = 0;
+        end = numVertices;
+    }
+    if (begin < end)
+    {
+        const std::vector<char> &interleaved = interleaveVertices(md, m, begin, end);
+        glBufferSubData(GL_ARRAY_BUFFER, begin * m.vertexStride, interleaved.size(), &interleaved[0]);
+    }
+}
+
 template<typename T> void ObjData<T>::updateBuffers()
 {
-    for (auto &md : meshData)
+    for (unsigned int i = 0; i < meshData.size(); i++)
     {
+        MeshData<T> &md = meshData[i];
         if (md.needsUpdate)
         {
-            for (auto &m : meshes)
+            std::shared_ptr<Mesh<T>> &m = meshes[i];
+            m->numVertices = md.vertices.size();
+            m->numIndices = md.indices.size();
+            m->firstVertex = md.vertices[0];
+
+            // only upload what's changed, unless we've run out of room,
+            // in which case we need new buffers with everything in.
+            // we don't orphan the buffers, as we'd lose what's in them
+            unsigned int numVertices = md.vertices.size();
+            if (m->packed)
+            {
+                updatePackedBuffer(md, *m);
+            }
+            else if (m->interleaved)
+            {
+                updateInterleavedBuffer(md, *m);
+            }
+            else if (numVertices > m->vertexCapacity)
+            {
+                m->vertexCapacity = std::max(numVertices, m->vertexCapacity * BUFFER_GROWTH_FACTOR);
+                reallocateBuffer(m->vertexBuffer, md.vertices, m->vertexCapacity);
+                if (md.hasTexture)
+                {
+                    reallocateBuffer(m->uvBuffer, md.uvs, m->vertexCapacity);
+                }
+                if (md.normals.size())
+                {
+                    reallocateBuffer(m->normalBuffer, md.normals, m->vertexCapacity);
+                }
+                if (md.colours.size())
+                {
+                    reallocateBuffer(m->colourBuffer, md.colours, m->vertexCapacity);
+                }
+            }
+            else
             {
-                if (m->name.compare(md.name) == 0)
+                uploadRange(m->vertexBuffer, md.vertices, m->dirtyVerticesBegin, m->dirtyVerticesEnd);
+                if (md.hasTexture)
+                {
+                    uploadRange(m->uvBuffer, md.uvs, m->dirtyVerticesBegin, m->dirtyVerticesEnd);
+                }
+                if (md.normals.size())
+                {
+                    uploadRange(m->normalBuffer, md.normals, m->dirtyVerticesBegin, m->dirtyVerticesEnd);
+                }
+                if (md.colours.size())
                 {
-                    m->numIndices = md.indices.size();
-                    m->firstVertex = md.vertices[0];
-
-                    // buffer orphaning
-                    // see: http://www.opengl-tutorial.org/intermediate-tutorials/billboards-particles/particles-instancing/
-                    // and: https://www.opengl.org/wiki/Buffer_Object_Streaming
-                    // TODO: does this work when md.vertices.size() changes?
-
-                    glBindBuffer(GL_ARRAY_BUFFER, m->vertexBuffer);
-                    glBufferData(GL_ARRAY_BUFFER, md.vertices.size() * sizeof(md.vertices[0]), NULL, GL_STREAM_DRAW);
-                    glBufferSubData(GL_ARRAY_BUFFER, 0, md.vertices.size() * sizeof(md.vertices[0]), &md.vertices[0]);
-
-                    if (md.hasTexture)
-                    {
-                        glBindBuffer(GL_ARRAY_BUFFER, m->uvBuffer);
-                        glBufferData(GL_ARRAY_BUFFER, md.uvs.size() * sizeof(md.uvs[0]), NULL, GL_STREAM_DRAW);
-                        glBufferSubData(GL_ARRAY_BUFFER, 0, md.uvs.size() * sizeof(md.uvs[0]), &md.uvs[0]);
-                    }
-
-                    glBindBuffer(GL_ARRAY_BUFFER, m->normalBuffer);
-                    glBufferData(GL_ARRAY_BUFFER, md.normals.size() * sizeof(md.normals[0]), NULL, GL_STREAM_DRAW);
-                    glBufferSubData(GL_ARRAY_BUFFER, 0, md.normals.size() * sizeof(md.normals[0]), &md.normals[0]);
-
-                    glBindBuffer(GL_ARRAY_BUFFER, m->indiceBuffer);
-                    glBufferData(GL_ARRAY_BUFFER, md.indices.size() * sizeof(md.indices[0]), NULL, GL_STREAM_DRAW);
-                    glBufferSubData(GL_ARRAY_BUFFER, 0, md.indices.size() * sizeof(md.indices[0]), &md.indices[0]);
-                    break;
+                    uploadRange(m->colourBuffer, md.colours, m->dirtyVerticesBegin, m->dirtyVerticesEnd);
                 }
             }
+
+            // once there are too many vertices for 16 bit indices every index
+            // has to be rewritten as 32 bit. we never go back to 16 bit, so a
+            // mesh hovering around the limit doesn't keep rewriting them all
+            unsigned int numIndices = md.indices.size();
+            bool widenIndices = (m->indexType == GL_UNSIGNED_SHORT) &&
+                                (chooseIndexType(numVertices) == GL_UNSIGNED_INT);
+            if (widenIndices)
+            {
+                m->indexType = GL_UNSIGNED_INT;
+            }
+            if (numIndices > m->indexCapacity || widenIndices)
+            {
+                m->indexCapacity = std::max(numIndices, m->indexCapacity * BUFFER_GROWTH_FACTOR);
+                reallocateIndices(m->indiceBuffer, m->indexType, md.indices, m->indexCapacity);
+            }
+            else
+            {
+                uploadIndexRange(m->indiceBuffer, m->indexType, md.indices, m->dirtyIndicesBegin, m->dirtyIndicesEnd);
+            }
+
+            m->dirtyVerticesBegin = UINT_MAX;
+            m->dirtyVerticesEnd = 0;
+            m->dirtyIndicesBegin = UINT_MAX;
+            m->dirtyIndicesEnd = 0;
+            md.needsUpdate = false;
         }
     }
 }
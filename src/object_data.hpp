@@ -4,20 +4,30 @@
 #include <string>
 #include <vector>
 #include <memory>
+#include <climits>
 
 #include <glm/glm.hpp>
 
 #include <GL/glew.h>
 
 class Texture;
+class Shader;
+
+// refers to a mesh in an ObjData, stays the same while other meshes are added and deleted
+typedef unsigned int MeshHandle;
+#define INVALID_MESH_HANDLE UINT_MAX
 
 template<typename T> struct MeshData
 {
-    std::vector<unsigned short> indices;
+    // always 32 bit here, the buffer uses 16 bit indices if they fit (see Mesh::indexType)
+    std::vector<unsigned int> indices;
     std::vector<T> vertices;
     std::vector<glm::vec2> uvs;
     std::vector<T> normals;
     std::vector<glm::vec3> colours;
+    // which layer of a texture array each vertex's texture is, -1 if it's not in one.
+    // only interleaved meshes have these, others use the layer of the mesh's texture
+    std::vector<float> textureLayers;
 
     std::string name;
     std::string texturePath;            // only one of texturePath
@@ -27,6 +37,17 @@ template<typename T> struct MeshData
     bool needsUpdate;
 };
 
+// packed vertices (see ObjData::usePackedVertices()) are the position as normalised unsigned
+// shorts, padded to a multiple of 4 bytes, then the normal as GL_INT_2_10_10_10_REV
+template<typename T> inline unsigned int packedPositionSize()
+{
+    return ((sizeof(T) / sizeof(float) * sizeof(GLushort) + 3) / 4) * 4;
+}
+template<typename T> inline unsigned int packedVertexSize()
+{
+    return packedPositionSize<T>() + sizeof(GLuint);
+}
+
 template<typename T> struct Mesh
 {
     ~Mesh()
@@ -39,20 +60,58 @@ template<typename T> struct Mesh
         {
             glDeleteBuffers(1, &uvBuffer);
         }
+        for (auto &va : vertexArrays)
+        {
+            glDeleteVertexArrays(1, &va.second);
+        }
     }
 
+    // bind the vertex array object that feeds our buffers into shader's attributes,
+    // so all that's left is the draw call. it's made the first time we're drawn with shader
+    void bindVertexArray(const Shader &shader);
+
     std::string name;
     bool hasTexture;
 
     T firstVertex; // needed for use with seperators
 
-    GLuint vertexBuffer;
+    GLuint vertexBuffer;    // positions and normals together if packed, everything if interleaved
     GLuint uvBuffer;
     GLuint normalBuffer;
     GLuint indiceBuffer;
     GLuint colourBuffer;
     std::shared_ptr<Texture> texture;
+    unsigned int numVertices;
     unsigned int numIndices;
+    GLenum indexType;   // GL_UNSIGNED_SHORT or GL_UNSIGNED_INT, pass to glDrawElements()
+
+    // packed positions go from 0 at positionOrigin to 1 at positionOrigin + positionScale
+    bool packed;
+    T positionOrigin;
+    T positionScale;
+
+    // interleaved vertices are the position, then the normal, uv, colour and texture layer if
+    // the mesh has them, at these offsets into each vertex. 0 means the mesh doesn't have that one
+    bool interleaved;
+    unsigned int vertexStride;
+    unsigned int normalOffset;
+    unsigned int uvOffset;
+    unsigned int colourOffset;
+    unsigned int textureLayerOffset;
+
+    // how many vertices and indices the buffers have room for
+    unsigned int vertexCapacity;
+    unsigned int indexCapacity;
+
+    // which elements have changed since the buffers were last updated,
+    // from begin up to (but not including) end
+    unsigned int dirtyVerticesBegin;
+    unsigned int dirtyVerticesEnd;
+    unsigned int dirtyIndicesBegin;
+    unsigned int dirtyIndicesEnd;
+
+    // each shader's attributes are in different places, so there's one for each shader we're drawn with
+    std::vector<std::pair<const Shader *, GLuint>> vertexArrays;
 };
 
 struct MeshAxis
@@ -80,29 +139,73 @@ public:
     ObjData();
     virtual ~ObjData();
 
-    bool addMesh(const MeshData<T> &data);
-
-    bool updateMesh(const MeshData<T> &data);
-
-    void deleteMesh(const std::string &name);
+    // keep positions and normals in one buffer of packed vertices, which is half the size
+    // or less. positions are only accurate to 1/65535th of the mesh's size, so it's for
+    // meshes that aren't too big, and it's only for ones without textures or colours.
+    // call before adding any meshes
+    void usePackedVertices() { packedVertices = true; }
+
+    // keep each vertex's position, normal, uv, colour and texture layer next to each other in one buffer,
+    // rather than a buffer for each. best for meshes that don't change much, as any change
+    // to a vertex uploads all of it. packed vertices are already interleaved, so this does
+    // nothing with them. call before adding any meshes
+    void useInterleavedVertices() { interleavedVertices = true; }
+
+    // returns INVALID_MESH_HANDLE if we couldn't create the mesh
+    MeshHandle addMesh(const MeshData<T> &data);
+    MeshHandle addMesh(MeshData<T> &&data);
+
+    // replace a mesh's data, only the parts that are different get uploaded
+    bool updateMesh(MeshHandle handle, const MeshData<T> &data);
+    bool updateMesh(MeshHandle handle, MeshData<T> &&data);
+
+    // or edit the data in place, to save copying it, and then say which vertices
+    // and indices (from begin up to but not including end) you changed.
+    // the pointer is only valid until meshes are added or deleted
+    MeshData<T> *getMeshData(MeshHandle handle);
+    const MeshData<T> *getMeshData(MeshHandle handle) const;
+    void markDirty(MeshHandle handle,
+                   unsigned int verticesBegin, unsigned int verticesEnd,
+                   unsigned int indicesBegin, unsigned int indicesEnd);
+
+    // searches through the names, so keep the handle rather than calling this every frame
+    MeshHandle findMesh(const std::string &name) const;
+
+    // the last mesh is moved into the deleted one's place in getMeshes()
+    void deleteMesh(MeshHandle handle);
     void deleteAll();
 
     void updateBuffers();
 
     const std::vector<std::shared_ptr<Mesh<T>>> &getMeshes() const { return meshes; }
+    // the handle of getMeshes()[index]
+    MeshHandle getMeshHandle(unsigned int index) const { return meshHandles[index]; }
 
     BoundingBox<T> getBoundingBox();
 
 protected:
+    MeshHandle addLastMesh();
     bool createBuffers(MeshData<T> &data);
+    // index into meshData and meshes, or INVALID_MESH_HANDLE
+    unsigned int getIndex(MeshHandle handle) const;
+    // mark what's different between data and what's at index as dirty
+    void findChanges(unsigned int index, const MeshData<T> &data);
 
     virtual void calculateBoundingBox() = 0;
 
+    // meshData[i] and meshes[i] are the same mesh, which has handle meshHandles[i]
     std::vector<MeshData<T>> meshData;
     std::vector<std::shared_ptr<Mesh<T>>> meshes;
+    std::vector<MeshHandle> meshHandles;
+    // where each handle's mesh is, INVALID_MESH_HANDLE for handles in freeHandles
+    std::vector<unsigned int> handleIndexes;
+    std::vector<MeshHandle> freeHandles;
 
     BoundingBox<T> cachedBoundingBox;
     bool boundingBoxIsCached;
+
+    bool packedVertices;
+    bool interleavedVertices;
 };
 
 class ObjData2D : public ObjData<glm::vec2>
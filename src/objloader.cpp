@@ -19,6 +19,8 @@ ObjLoader::ObjLoader(const std::string &objFilePath, const std::string &_texture
     : ObjData3D(), objPath(objFilePath), textureMapPath(_textureMapPath),
       progressBar(_progressBar), progressType(_progressType)
 {
+    // models are loaded once and never change
+    useInterleavedVertices();
 }
 
 ObjLoader::~ObjLoader()
@@ -235,6 +237,17 @@ bool ObjLoader::loadObj()
         }
     }
 
+    // put textures that are the same size together in arrays, so we can be drawn with fewer binds
+    std::vector<std::shared_ptr<Texture>> textures;
+    for (auto &mesh : meshes)
+    {
+        if (mesh->hasTexture)
+        {
+            textures.push_back(mesh->texture);
+        }
+    }
+    Texture::packIntoArrays(textures);
+
     // clean up the ASSIMP importer
     importer.FreeScene();
 
@@ -11,7 +11,7 @@
 ProgressBar::ProgressBar(std::map<ProgressType, unsigned int> _weights, GLFWwindow* _window, std::shared_ptr<const Shader> _shader, std::shared_ptr<Texture> _font)
     : weights(_weights), window(_window), shader(_shader), font(_font),
       progressBar(std::make_unique<Shape2D>(shader)),
-      progressText(std::make_unique<Text>(shader)), lastTotalPercent(0.0f)
+      progressText(std::make_unique<Text>(shader)), lastTotalPercent(0.0f), barMesh(INVALID_MESH_HANDLE)
 {
     progressBar->addRect(glm::vec2(PROGRESS_BAR_START_X - 2.0f, PROGRESS_BAR_END_Y + 2.0f), glm::vec2(PROGRESS_BAR_END_X + 2.0f, PROGRESS_BAR_END_Y + 2.0f), glm::vec2(PROGRESS_BAR_END_X + 2.0f, PROGRESS_BAR_START_Y - 2.0f), glm::vec2(PROGRESS_BAR_START_X - 2.0f, PROGRESS_BAR_START_Y - 2.0f),
                         glm::vec3(1.0f, 1.0f, 1.0f), glm::vec3(1.0f, 1.0f, 1.0f), glm::vec3(1.0f, 1.0f, 1.0f), glm::vec3(1.0f, 1.0f, 1.0f));
@@ -49,8 +49,8 @@ void ProgressBar::update(ProgressType type, float percentage)
     {
         lastTotalPercent = currentTotalPercent;
         float end_x = PROGRESS_BAR_START_X + (PROGRESS_BAR_END_X - PROGRESS_BAR_START_X) * currentTotalPercent;
-        progressBar->deleteObjData("progress_bar");
-        progressBar->addRect(glm::vec2(PROGRESS_BAR_START_X, PROGRESS_BAR_END_Y), glm::vec2(end_x, PROGRESS_BAR_END_Y), glm::vec2(end_x, PROGRESS_BAR_START_Y), glm::vec2(PROGRESS_BAR_START_X, PROGRESS_BAR_START_Y),
+        progressBar->deleteObjData(barMesh);
+        barMesh = progressBar->addRect(glm::vec2(PROGRESS_BAR_START_X, PROGRESS_BAR_END_Y), glm::vec2(end_x, PROGRESS_BAR_END_Y), glm::vec2(end_x, PROGRESS_BAR_START_Y), glm::vec2(PROGRESS_BAR_START_X, PROGRESS_BAR_START_Y),
                             glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(currentTotalPercent, 1.0f - currentTotalPercent, 0.0f), glm::vec3(currentTotalPercent, 1.0f - currentTotalPercent, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f),
                             "progress_bar");
     }
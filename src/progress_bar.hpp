@@ -1,6 +1,8 @@
 #ifndef __PROGRESS_BAR_HPP
 #define __PROGRESS_BAR_HPP
 
+#include "object_data.hpp"
+
 #include <map>
 #include <string>
 #include <memory>
@@ -41,6 +43,7 @@ protected:
     std::unique_ptr<Text> progressText;
 
     float lastTotalPercent;
+    MeshHandle barMesh;
 };
 
 #endif
@@ -161,7 +161,7 @@ bool RenderPipeline::setupScreenQuad()
     md.indices.push_back(0); md.indices.push_back(1); md.indices.push_back(2);
     md.indices.push_back(0); md.indices.push_back(2); md.indices.push_back(3);
 
-    if (!screenQuad->addMesh(md))
+    if (screenQuad->addMesh(md) == INVALID_MESH_HANDLE)
     {
         printf("Failed to set up screen quad\n");
         return false;
@@ -234,7 +234,7 @@ void RenderPipeline::doLightingPass() const
     geometryPassFBO->bindTextures();
 
     // set screen resolution
-    glUniform2fv(lightingPassShader->getUniformID(SHARDER_UNIFORM_SCREEN_RES), 1, &screenResolutionVec[0]);
+    lightingPassShader->setUniform(SHARDER_UNIFORM_SCREEN_RES, screenResolutionVec);
 
     world->sendLightingInfoToShader(lightingPassShader);
 }
@@ -296,9 +296,9 @@ void RenderPipeline::doBlurPass() const
             first = false;
         }
 
-        glUniform1i(blurPassShader->getUniformID(SHADER_UNIFORM_HORIZONTAL_FLAG), (pass + 1) % 2);
-        glUniform1i(blurPassShader->getUniformID(SHADER_UNIFORM_COLOUR_TEXTURE_SAMPLER), 0);
-        glUniform2fv(blurPassShader->getUniformID(SHARDER_UNIFORM_SCREEN_RES), 1, &blurOutputResolutionVec[0]);
+        blurPassShader->setUniform(SHADER_UNIFORM_HORIZONTAL_FLAG, (int)((pass + 1) % 2));
+        blurPassShader->setUniform(SHADER_UNIFORM_COLOUR_TEXTURE_SAMPLER, 0);
+        blurPassShader->setUniform(SHARDER_UNIFORM_SCREEN_RES, blurOutputResolutionVec);
 
         renderScreenQuad(blurPassShader);
     }
@@ -325,9 +325,9 @@ void RenderPipeline::doHDRPass() const
     // therefore [0] always contains uor finished blur
     blurFBOs[0]->bindTextures(nextTextureToBind);
 
-    glUniform1i(hdrPassShader->getUniformID(SHADER_UNIFORM_COLOUR_TEXTURE_SAMPLER), 0);
-    glUniform1i(hdrPassShader->getUniformID(SHADER_UNIFORM_BLUR_TEXTURE_SAMPLER), 1);
-    glUniform2fv(hdrPassShader->getUniformID(SHARDER_UNIFORM_SCREEN_RES), 1, &screenResolutionVec[0]);
+    hdrPassShader->setUniform(SHADER_UNIFORM_COLOUR_TEXTURE_SAMPLER, 0);
+    hdrPassShader->setUniform(SHADER_UNIFORM_BLUR_TEXTURE_SAMPLER, 1);
+    hdrPassShader->setUniform(SHARDER_UNIFORM_SCREEN_RES, screenResolutionVec);
 
     renderScreenQuad(hdrPassShader);
 }
@@ -346,19 +346,10 @@ void RenderPipeline::render2D() const
 
 void RenderPipeline::renderScreenQuad(std::shared_ptr<const Shader> shader) const
 {
-    GLuint vertexPosition_ScreenID = shader->getAttribID(SHADER_ATTRIB_VERTEX_POS);
-
     auto sqMeshes = screenQuad->getMeshes();
     for (auto &it : sqMeshes)
     {
-        glEnableVertexAttribArray(vertexPosition_ScreenID);
-
-        glBindBuffer(GL_ARRAY_BUFFER, it->vertexBuffer);
-        glVertexAttribPointer(vertexPosition_ScreenID, 2, GL_FLOAT, GL_FALSE, 0, (void *)0);
-
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, it->indiceBuffer);
-        glDrawElements(GL_TRIANGLES, it->numIndices, GL_UNSIGNED_SHORT, (void *)0);
-
-        glDisableVertexAttribArray(vertexPosition_ScreenID);
+        it->bindVertexArray(*shader);
+        glDrawElements(GL_TRIANGLES, it->numIndices, it->indexType, (void *)0);
     }
 }
@@ -1,6 +1,8 @@
 #include "shader.hpp"
+#include "texture.hpp"
 
 #include <stdio.h>
+#include <string.h>
 #include <string>
 #include <vector>
 #include <iostream>
@@ -8,6 +10,8 @@
 #include <algorithm>
 
 std::shared_ptr<const Shader> Shader::shaders[NUM_SHADER_TYPES];
+unsigned int Shader::uniformWrites = 0;
+unsigned int Shader::uniformWritesSkipped = 0;
 
 Shader::Shader(const std::string &vertexShaderPath,
                const std::string &fragmentShaderPath,
@@ -20,6 +24,7 @@ Shader::Shader(const std::string &vertexShaderPath,
     for (unsigned int i = 0; i < SHADER_NUM_UNIFORM_IDS; i++)
     {
         uniformIDs[i] = -1;
+        uniformValueKnown[i] = false;
     }
     for (unsigned int i = 0; i < SHADER_NUM_ATTRIB_IDS; i++)
     {
@@ -186,15 +191,97 @@ void Shader::useShader() const
     glUseProgram(programID);
 }
 
+bool Shader::uniformChanged(ShaderUniformID id, const void *value, unsigned int size) const
+{
+    if (id >= SHADER_NUM_UNIFORM_IDS || uniformIDs[id] == (GLuint)-1)
+    {
+        return false;
+    }
+
+    uniformWrites++;
+    if (uniformValueKnown[id] && memcmp(uniformValues[id], value, size) == 0)
+    {
+        uniformWritesSkipped++;
+        return false;
+    }
+
+    memcpy(uniformValues[id], value, size);
+    uniformValueKnown[id] = true;
+    return true;
+}
+
+void Shader::setUniform(ShaderUniformID id, int value) const
+{
+    if (uniformChanged(id, &value, sizeof(value)))
+    {
+        glUniform1i(uniformIDs[id], value);
+    }
+}
+
+void Shader::setUniform(ShaderUniformID id, float value) const
+{
+    if (uniformChanged(id, &value, sizeof(value)))
+    {
+        glUniform1f(uniformIDs[id], value);
+    }
+}
+
+void Shader::setUniform(ShaderUniformID id, const glm::vec2 &value) const
+{
+    if (uniformChanged(id, &value[0], sizeof(value)))
+    {
+        glUniform2fv(uniformIDs[id], 1, &value[0]);
+    }
+}
+
+void Shader::setUniform(ShaderUniformID id, const glm::vec3 &value) const
+{
+    if (uniformChanged(id, &value[0], sizeof(value)))
+    {
+        glUniform3fv(uniformIDs[id], 1, &value[0]);
+    }
+}
+
+void Shader::setUniform(ShaderUniformID id, const glm::mat3 &value) const
+{
+    if (uniformChanged(id, &value[0][0], sizeof(value)))
+    {
+        glUniformMatrix3fv(uniformIDs[id], 1, GL_FALSE, &value[0][0]);
+    }
+}
+
+void Shader::setUniform(ShaderUniformID id, const glm::mat4 &value) const
+{
+    if (uniformChanged(id, &value[0][0], sizeof(value)))
+    {
+        glUniformMatrix4fv(uniformIDs[id], 1, GL_FALSE, &value[0][0]);
+    }
+}
+
+void Shader::resetUniformCounters()
+{
+    uniformWrites = 0;
+    uniformWritesSkipped = 0;
+}
+
+// the samplers all start on unit 0, point them at the units Texture::bind() uses
+void Shader::setTextureUnits() const
+{
+    useShader();
+    setUniform(SHADER_UNIFORM_TEXTURE_SAMPLER, TEXTURE_UNIT);
+    setUniform(SHADER_UNIFORM_TEXTURE_ARRAY_SAMPLER, TEXTURE_ARRAY_UNIT);
+}
+
 bool Shader::setupShaders()
 {
-    shaders[SHADER_TYPE_MAIN_GEOMETRY_PASS]     = setupMainGeometryPassShader();
-    shaders[SHADER_TYPE_EXPLODE_GEOMETRY_PASS]  = setupExplodeShader();
-    shaders[SHADER_TYPE_LIGHTING_PASS]          = setupLightingPassShader();
-    shaders[SHADER_TYPE_HDR_PASS]               = setupHDRShader();
-    shaders[SHADER_TYPE_LAMP]                   = setupLampShader();
-    shaders[SHADER_TYPE_BLUR]                   = setupBlurShader();
-    shaders[SHADER_TYPE_2D]                     = setup2DShader();
+    shaders[SHADER_TYPE_MAIN_GEOMETRY_PASS]        = setupMainGeometryPassShader();
+    shaders[SHADER_TYPE_EXPLODE_GEOMETRY_PASS]     = setupExplodeShader();
+    shaders[SHADER_TYPE_LIGHT_TRAIL_GEOMETRY_PASS] = setupLightTrailShader();
+    shaders[SHADER_TYPE_LIGHTING_PASS]             = setupLightingPassShader();
+    shaders[SHADER_TYPE_HDR_PASS]                  = setupHDRShader();
+    shaders[SHADER_TYPE_LAMP]                      = setupLampShader();
+    shaders[SHADER_TYPE_BLUR]                      = setupBlurShader();
+    shaders[SHADER_TYPE_2D]                        = setup2DShader();
 
     for (unsigned int i = 0; i < NUM_SHADER_TYPES; i++)
     {
@@ -233,6 +320,7 @@ std::shared_ptr<Shader> Shader::setupMainGeometryPassShader(const std::string *g
             !shader->addAttribID("vertexPosition_Model", SHADER_ATTRIB_VERTEX_POS) ||
             !shader->addAttribID("vertexNormal_Model", SHADER_ATTRIB_VERTEX_NORMAL) ||
             !shader->addAttribID("vertexTextureUV", SHADER_ATTRIB_VERTEX_UV) ||
+            !shader->addAttribID("vertexTextureLayer", SHADER_ATTRIB_VERTEX_TEXTURE_LAYER) ||
             // vertex params (static)
             !shader->addUniformID("MVP", SHADER_UNIFORM_MVP) ||
             !shader->addUniformID("MV", SHADER_UNIFORM_MODEL_VIEW_MATRIX) ||
@@ -240,11 +328,16 @@ std::shared_ptr<Shader> Shader::setupMainGeometryPassShader(const std::string *g
             // fragment params
             !shader->addUniformID("fragmentIsTexture", SHADER_UNIFORM_IS_TEXTURE) ||
             !shader->addUniformID("textureSampler", SHADER_UNIFORM_TEXTURE_SAMPLER) ||
+            !shader->addUniformID("textureArraySampler", SHADER_UNIFORM_TEXTURE_ARRAY_SAMPLER) ||
             !shader->addUniformID("fragmentColour", SHADER_UNIFORM_FRAGMENT_COLOUR))
         {
             printf("Error adding shader IDs\n");
             shader = NULL;
         }
+        else
+        {
+            shader->setTextureUnits();
+        }
     }
 
     return shader;
@@ -268,6 +361,48 @@ std::shared_ptr<Shader> Shader::setupExplodeShader()
     return shader;
 }
 
+std::shared_ptr<Shader> Shader::setupLightTrailShader()
+{
+    // light trails are drawn as lines along their path, which the
+    // geometry shader turns into walls. the fragment shader is the main one
+    std::string gsPath = "shaders/light_trail_geometry_pass.gs";
+    std::shared_ptr<Shader> shader = std::make_shared<Shader>("shaders/light_trail_geometry_pass.vs", "shaders/main_geometry_pass.fs", &gsPath);
+    if (!shader || !shader->compile())
+    {
+        printf("Failed to compile light trail geometry pass shader\n");
+        shader = NULL;
+    }
+    else
+    {
+        if (// vertex params (variable)
+            !shader->addAttribID("pathPosition_Model", SHADER_ATTRIB_VERTEX_POS) ||
+            !shader->addAttribID("pathNormal_Model", SHADER_ATTRIB_VERTEX_NORMAL) ||
+            !shader->addUniformID("positionOrigin", SHADER_UNIFORM_POSITION_ORIGIN) ||
+            !shader->addUniformID("positionScale", SHADER_UNIFORM_POSITION_SCALE) ||
+            // geometry params (static)
+            !shader->addUniformID("MVP", SHADER_UNIFORM_MVP) ||
+            !shader->addUniformID("MV", SHADER_UNIFORM_MODEL_VIEW_MATRIX) ||
+            !shader->addUniformID("normalMV", SHADER_UNIFORM_NORMAL_MODEL_VIEW_MATRIX) ||
+            !shader->addUniformID("wallHeight", SHADER_UNIFORM_WALL_HEIGHT) ||
+            // fragment params
+            !shader->addUniformID("fragmentIsTexture", SHADER_UNIFORM_IS_TEXTURE) ||
+            !shader->addUniformID("textureSampler", SHADER_UNIFORM_TEXTURE_SAMPLER) ||
+            !shader->addUniformID("textureArraySampler", SHADER_UNIFORM_TEXTURE_ARRAY_SAMPLER) ||
+            !shader->addUniformID("fragmentColour", SHADER_UNIFORM_FRAGMENT_COLOUR))
+        {
+            printf("Error adding light trail shader IDs\n");
+            shader = NULL;
+        }
+        else
+        {
+            // we never use the textures, but the samplers still can't share a unit
+            shader->setTextureUnits();
+        }
+    }
+
+    return shader;
+}
+
 std::shared_ptr<Shader> Shader::setupLightingPassShader()
 {
     // first init main shader
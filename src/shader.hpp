@@ -1,15 +1,18 @@
 #ifndef __SHADER_HPP
 #define __SHADER_HPP
 
-#include <GL/glew.h>
-
 #include <string>
 #include <memory>
 
+#include <glm/glm.hpp>
+
+#include <GL/glew.h>
+
 enum ShaderType
 {
     SHADER_TYPE_MAIN_GEOMETRY_PASS = 0,
     SHADER_TYPE_EXPLODE_GEOMETRY_PASS,
+    SHADER_TYPE_LIGHT_TRAIL_GEOMETRY_PASS,
     SHADER_TYPE_LIGHTING_PASS,
     SHADER_TYPE_HDR_PASS,
     SHADER_TYPE_LAMP,
@@ -37,6 +40,7 @@ enum ShaderUniformID
 
     SHADER_UNIFORM_IS_TEXTURE,
     SHADER_UNIFORM_TEXTURE_SAMPLER,
+    SHADER_UNIFORM_TEXTURE_ARRAY_SAMPLER,
     SHADER_UNIFORM_FRAGMENT_COLOUR,
 
     SHADER_UNIFORM_GEOMETRY_TEXTURE_SAMPLER,
@@ -46,6 +50,9 @@ enum ShaderUniformID
 
     SHADER_UNIFORM_HORIZONTAL_FLAG,
     SHADER_UNIFORM_EXPLODE,
+    SHADER_UNIFORM_WALL_HEIGHT,
+    SHADER_UNIFORM_POSITION_ORIGIN,
+    SHADER_UNIFORM_POSITION_SCALE,
 
     SHADER_NUM_UNIFORM_IDS
 };
@@ -56,6 +63,7 @@ enum ShaderAttribID
     SHADER_ATTRIB_VERTEX_NORMAL,
     SHADER_ATTRIB_VERTEX_UV,
     SHADER_ATTRIB_VERTEX_COLOUR,
+    SHADER_ATTRIB_VERTEX_TEXTURE_LAYER,
 
     SHADER_NUM_ATTRIB_IDS
 };
@@ -76,14 +84,33 @@ public:
 
     void useShader() const;
 
+    // send a uniform to the shader, which has to be in use. the last value sent is
+    // kept, so sending the same one again doesn't make a glUniform call
+    void setUniform(ShaderUniformID id, int value) const;
+    void setUniform(ShaderUniformID id, float value) const;
+    void setUniform(ShaderUniformID id, const glm::vec2 &value) const;
+    void setUniform(ShaderUniformID id, const glm::vec3 &value) const;
+    void setUniform(ShaderUniformID id, const glm::mat3 &value) const;
+    void setUniform(ShaderUniformID id, const glm::mat4 &value) const;
+
+    // setUniform() calls in every shader since the last reset, and how many
+    // of them were skipped because the uniform already had that value
+    static unsigned int getUniformWrites() { return uniformWrites; }
+    static unsigned int getUniformWritesSkipped() { return uniformWritesSkipped; }
+    static void resetUniformCounters();
+
     static bool setupShaders();
     static std::shared_ptr<const Shader> getShader(ShaderType type);
 
 protected:
     bool compileShader(const std::string &path, GLuint &shaderID) const;
+    void setTextureUnits() const;
+    // false if the uniform isn't in the shader or already has value, otherwise remembers it
+    bool uniformChanged(ShaderUniformID id, const void *value, unsigned int size) const;
 
     static std::shared_ptr<Shader> setupMainGeometryPassShader(const std::string *geometryShader = NULL);
     static std::shared_ptr<Shader> setupExplodeShader();
+    static std::shared_ptr<Shader> setupLightTrailShader();
     static std::shared_ptr<Shader> setupLightingPassShader();
     static std::shared_ptr<Shader> setupHDRShader();
     static std::shared_ptr<Shader> setupLampShader();
@@ -99,6 +126,13 @@ protected:
 
     GLuint uniformIDs[SHADER_NUM_UNIFORM_IDS];
     GLuint attribIDs[SHADER_NUM_ATTRIB_IDS];
+
+    // what each uniform was last set to, big enough for the largest type setUniform() takes
+    mutable unsigned char uniformValues[SHADER_NUM_UNIFORM_IDS][sizeof(glm::mat4)];
+    mutable bool uniformValueKnown[SHADER_NUM_UNIFORM_IDS];
+
+    static unsigned int uniformWrites;
+    static unsigned int uniformWritesSkipped;
 };
 
 #endif
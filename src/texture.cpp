@@ -1,9 +1,12 @@
 #include "texture.hpp"
+#include "shader.hpp"
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <string>
+#include <vector>
+#include <algorithm>
 
 #include <GL/glew.h>
 
@@ -16,19 +19,31 @@
 std::map<std::string, std::shared_ptr<Texture>> Texture::textureCache;
 
 Texture::Texture(const std::string &imagePath)
-    : path(imagePath), textureID(-1)
+    : path(imagePath), textureID(-1), target(GL_TEXTURE_2D),
+      format(0), width(0), height(0), mipMapCount(0), layer(0)
 {
 }
 
 Texture::~Texture()
 {
-    if (textureID != -1)
+    // layers leave deleting the texture to their array
+    if (textureID != -1 && !array)
     {
         glDeleteTextures(1, &textureID);
     }
 }
 
-bool Texture::loadDDS()
+// a DDS file's compressed image, with all its mipmaps one after the other
+struct DDSImage
+{
+    GLenum format;
+    unsigned int width;
+    unsigned int height;
+    unsigned int mipMapCount;
+    std::vector<unsigned char> data;
+};
+
+static bool readDDS(const std::string &path, DDSImage &image)
 {
     unsigned char header[124];
 
@@ -54,31 +69,48 @@ bool Texture::loadDDS()
     /* get the surface desc */
     fread(&header, 124, 1, fp);
 
-    unsigned int height      = *(unsigned int*)&(header[8 ]);
-    unsigned int width         = *(unsigned int*)&(header[12]);
-    unsigned int linearSize     = *(unsigned int*)&(header[16]);
-    unsigned int mipMapCount = *(unsigned int*)&(header[24]);
+    image.height             = *(unsigned int*)&(header[8 ]);
+    image.width              = *(unsigned int*)&(header[12]);
+    unsigned int linearSize  = *(unsigned int*)&(header[16]);
+    image.mipMapCount        = *(unsigned int*)&(header[24]);
     unsigned int fourCC      = *(unsigned int*)&(header[80]);
 
+    switch(fourCC)
+    {
+        case FOURCC_DXT1:   image.format = GL_COMPRESSED_RGBA_S3TC_DXT1_EXT; break;
+        case FOURCC_DXT3:   image.format = GL_COMPRESSED_RGBA_S3TC_DXT3_EXT; break;
+        case FOURCC_DXT5:   image.format = GL_COMPRESSED_RGBA_S3TC_DXT5_EXT; break;
+        default:            fclose(fp); return false;
+    }
 
-    unsigned char * buffer;
-    unsigned int bufsize;
     /* how big is it going to be including all mipmaps? */
-    bufsize = mipMapCount > 1 ? linearSize * 2 : linearSize;
-    buffer = (unsigned char*)malloc(bufsize * sizeof(unsigned char));
-    fread(buffer, 1, bufsize, fp);
+    unsigned int bufsize = image.mipMapCount > 1 ? linearSize * 2 : linearSize;
+    image.data.resize(bufsize);
+    fread(&image.data[0], 1, bufsize, fp);
     /* close the file pointer */
     fclose(fp);
 
-    unsigned int components  = (fourCC == FOURCC_DXT1) ? 3 : 4;
-    unsigned int format;
-    switch(fourCC)
+    return true;
+}
+
+// size in bytes of one mipmap level
+static unsigned int levelSize(GLenum format, unsigned int width, unsigned int height)
+{
+    unsigned int blockSize = (format == GL_COMPRESSED_RGBA_S3TC_DXT1_EXT) ? 8 : 16;
+    return ((width + 3) / 4) * ((height + 3) / 4) * blockSize;
+}
+
+bool Texture::loadDDS()
+{
+    DDSImage image;
+    if (!readDDS(path, image))
     {
-        case FOURCC_DXT1:   format = GL_COMPRESSED_RGBA_S3TC_DXT1_EXT; break;
-        case FOURCC_DXT3:   format = GL_COMPRESSED_RGBA_S3TC_DXT3_EXT; break;
-        case FOURCC_DXT5:   format = GL_COMPRESSED_RGBA_S3TC_DXT5_EXT; break;
-        default:            free(buffer); return false;
+        return false;
     }
+    format = image.format;
+    width = image.width;
+    height = image.height;
+    mipMapCount = image.mipMapCount;
 
     // Create one OpenGL texture
     glGenTextures(1, &textureID);
@@ -87,34 +119,158 @@ bool Texture::loadDDS()
     glBindTexture(GL_TEXTURE_2D, textureID);
     glPixelStorei(GL_UNPACK_ALIGNMENT,1);
 
-    unsigned int blockSize = (format == GL_COMPRESSED_RGBA_S3TC_DXT1_EXT) ? 8 : 16;
+    unsigned int levelWidth = width;
+    unsigned int levelHeight = height;
     unsigned int offset = 0;
 
     /* load the mipmaps */
-    for (unsigned int level = 0; level < mipMapCount && (width || height); ++level)
+    for (unsigned int level = 0; level < mipMapCount; ++level)
     {
-        unsigned int size = ((width+3)/4)*((height+3)/4)*blockSize;
-        glCompressedTexImage2D(GL_TEXTURE_2D, level, format, width, height, 0, size, buffer + offset);
+        unsigned int size = levelSize(format, levelWidth, levelHeight);
+        glCompressedTexImage2D(GL_TEXTURE_2D, level, format, levelWidth, levelHeight, 0, size, &image.data[offset]);
 
         offset += size;
-        width  /= 2;
-        height /= 2;
 
-        // Deal with Non-Power-Of-Two textures. This code is not included in the webpage to reduce clutter.
-        if(width < 1) width = 1;
-        if(height < 1) height = 1;
+        // Deal with Non-Power-Of-Two textures
+        levelWidth = (levelWidth > 1) ? levelWidth / 2 : 1;
+        levelHeight = (levelHeight > 1) ? levelHeight / 2 : 1;
     }
 
-    free(buffer);
+    return true;
+}
+
+// make us an array with a layer for each of layers, which must all be the same size and format
+bool Texture::loadArray(const std::vector<std::shared_ptr<Texture>> &layers)
+{
+    target = GL_TEXTURE_2D_ARRAY;
+    format = layers[0]->format;
+    width = layers[0]->width;
+    height = layers[0]->height;
+    mipMapCount = layers[0]->mipMapCount;
+
+    glGenTextures(1, &textureID);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, textureID);
+    glPixelStorei(GL_UNPACK_ALIGNMENT,1);
+
+    // make room for every layer of every mipmap, then fill them in from the files
+    unsigned int levelWidth = width;
+    unsigned int levelHeight = height;
+    for (unsigned int level = 0; level < mipMapCount; ++level)
+    {
+        unsigned int size = levelSize(format, levelWidth, levelHeight);
+        glCompressedTexImage3D(GL_TEXTURE_2D_ARRAY, level, format, levelWidth, levelHeight, layers.size(), 0, size * layers.size(), NULL);
+
+        levelWidth = (levelWidth > 1) ? levelWidth / 2 : 1;
+        levelHeight = (levelHeight > 1) ? levelHeight / 2 : 1;
+    }
+
+    for (unsigned int i = 0; i < layers.size(); i++)
+    {
+        DDSImage image;
+        if (!readDDS(layers[i]->path, image))
+        {
+            return false;
+        }
+
+        levelWidth = width;
+        levelHeight = height;
+        unsigned int offset = 0;
+        for (unsigned int level = 0; level < mipMapCount; ++level)
+        {
+            unsigned int size = levelSize(format, levelWidth, levelHeight);
+            glCompressedTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, 0, 0, i, levelWidth, levelHeight, 1, format, size, &image.data[offset]);
+
+            offset += size;
+            levelWidth = (levelWidth > 1) ? levelWidth / 2 : 1;
+            levelHeight = (levelHeight > 1) ? levelHeight / 2 : 1;
+        }
+    }
 
     return true;
 }
 
-void Texture::bind(GLuint textureSamplerID) const
+void Texture::packIntoArrays(const std::vector<std::shared_ptr<Texture>> &textures)
 {
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, textureID);
-    glUniform1i(textureSamplerID, 0);
+    // sort them into ones that can share an array. textures
+    // are often used by lots of meshes, so only take each once
+    std::vector<std::vector<std::shared_ptr<Texture>>> matches;
+    for (auto &texture : textures)
+    {
+        if (!texture || texture->isArrayLayer() || texture->target != GL_TEXTURE_2D)
+        {
+            continue;
+        }
+
+        bool found = false;
+        for (auto &match : matches)
+        {
+            if (std::find(match.begin(), match.end(), texture) != match.end())
+            {
+                found = true;
+                break;
+            }
+            const Texture &first = *match[0];
+            if (first.format == texture->format &&
+                first.width == texture->width &&
+                first.height == texture->height &&
+                first.mipMapCount == texture->mipMapCount)
+            {
+                match.push_back(texture);
+                found = true;
+                break;
+            }
+        }
+        if (!found)
+        {
+            matches.push_back(std::vector<std::shared_ptr<Texture>>(1, texture));
+        }
+    }
+
+    for (auto &match : matches)
+    {
+        // nothing to gain from an array of one
+        if (match.size() < 2)
+        {
+            continue;
+        }
+
+        std::shared_ptr<Texture> array(new Texture(match[0]->path + " array"));
+        if (!array->loadArray(match))
+        {
+            // leave them as they are
+            printf("unable to make texture array for %s\n", match[0]->path.c_str());
+            continue;
+        }
+
+        for (unsigned int i = 0; i < match.size(); i++)
+        {
+            Texture &texture = *match[i];
+            glDeleteTextures(1, &texture.textureID);
+            texture.textureID = array->textureID;
+            texture.target = GL_TEXTURE_2D_ARRAY;
+            texture.array = array;
+            texture.layer = i;
+        }
+    }
+}
+
+void Texture::bind(const Shader &shader, ShaderUniformID samplerID) const
+{
+    GLuint unit = (target == GL_TEXTURE_2D_ARRAY) ? TEXTURE_ARRAY_UNIT : TEXTURE_UNIT;
+    glActiveTexture(GL_TEXTURE0 + unit);
+    glBindTexture(target, textureID);
+    shader.setUniform(samplerID, (int)unit);
+}
+
+void Texture::bind(const Shader &shader) const
+{
+    bind(shader, isArrayLayer() ? SHADER_UNIFORM_TEXTURE_ARRAY_SAMPLER : SHADER_UNIFORM_TEXTURE_SAMPLER);
+
+    GLuint textureLayerID = shader.getAttribID(SHADER_ATTRIB_VERTEX_TEXTURE_LAYER);
+    if (textureLayerID != (GLuint)-1)
+    {
+        glVertexAttrib1f(textureLayerID, isArrayLayer() ? (float)layer : -1.0f);
+    }
 }
 
 std::shared_ptr<Texture> Texture::getOrCreate(const std::string &imagePath)
@@ -1,12 +1,20 @@
 #ifndef __TEXTURE_HPP
 #define __TEXTURE_HPP
 
+#include "shader.hpp"
+
 #include <string>
 #include <memory>
 #include <map>
+#include <vector>
 
 #include <GL/glew.h>
 
+// the units textures are bound to. a sampler2D and a sampler2DArray
+// can't share one, even if only one of them is used
+#define TEXTURE_UNIT        0
+#define TEXTURE_ARRAY_UNIT  1
+
 class Texture
 {
 public:
@@ -14,14 +22,38 @@ public:
 
     static std::shared_ptr<Texture> getOrCreate(const std::string &imagepath);
 
-    void bind(GLuint textureSamplerID) const;
+    // move textures that are the same size and format into texture arrays, so everything
+    // using them can be drawn without binding another texture. each one carries on as
+    // a layer of its array, which needs a sampler2DArray rather than a sampler2D
+    static void packIntoArrays(const std::vector<std::shared_ptr<Texture>> &textures);
+
+    void bind(const Shader &shader, ShaderUniformID samplerID) const;
+    // for shaders with both samplers and a texture layer attribute, like the main geometry
+    // pass. vertices without their own layer get ours
+    void bind(const Shader &shader) const;
+
+    bool isArrayLayer() const { return array != NULL; }
+    unsigned int getLayer() const { return layer; }
+    // textures with the same ID are bound the same way, only their layers are different
+    GLuint getTextureID() const { return textureID; }
 
 protected:
     Texture(const std::string &imagepath);
     bool loadDDS();
+    bool loadArray(const std::vector<std::shared_ptr<Texture>> &layers);
 
     std::string path;
     GLuint textureID;
+    GLenum target;      // GL_TEXTURE_2D or GL_TEXTURE_2D_ARRAY
+
+    GLenum format;
+    unsigned int width;
+    unsigned int height;
+    unsigned int mipMapCount;
+
+    // the array we've been moved into, which owns textureID
+    std::shared_ptr<Texture> array;
+    unsigned int layer;
 
     static std::map<std::string, std::shared_ptr<Texture>> textureCache;
 };
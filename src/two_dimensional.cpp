@@ -20,9 +20,9 @@ Object2D::~Object2D()
 {
 }
 
-void Object2D::deleteObjData(const std::string &name)
+void Object2D::deleteObjData(MeshHandle handle)
 {
-    objData->deleteMesh(name);
+    objData->deleteMesh(handle);
 }
 
 void Object2D::deleteAllObjData()
@@ -32,49 +32,19 @@ void Object2D::deleteAllObjData()
 
 void Object2D::drawMesh(const std::shared_ptr<Mesh<glm::vec2>> &mesh) const
 {
-    GLuint vertexTextureUVID = shader->getAttribID(SHADER_ATTRIB_VERTEX_UV);
-    GLuint vertexPosition_screenspaceID = shader->getAttribID(SHADER_ATTRIB_VERTEX_POS);
-    GLuint vertexColourID = shader->getAttribID(SHADER_ATTRIB_VERTEX_COLOUR);
-    GLuint textureSamplerID = shader->getUniformID(SHADER_UNIFORM_TEXTURE_SAMPLER);
-    GLuint fragmentIsTextureID = shader->getUniformID(SHADER_UNIFORM_IS_TEXTURE);
-
-    glEnableVertexAttribArray(vertexPosition_screenspaceID);
-
     if (mesh->hasTexture)
     {
-        glEnableVertexAttribArray(vertexTextureUVID);
-        glBindBuffer(GL_ARRAY_BUFFER, mesh->uvBuffer);
-        glVertexAttribPointer(vertexTextureUVID, 2, GL_FLOAT, GL_FALSE, 0, (void *)0);
-
-        glUniform1f(fragmentIsTextureID, 1.0f);
-
-        mesh->texture->bind(textureSamplerID);
-    }
-    else
-    {
-        glEnableVertexAttribArray(vertexColourID);
-        glBindBuffer(GL_ARRAY_BUFFER, mesh->colourBuffer);
-        glVertexAttribPointer(vertexColourID, 3, GL_FLOAT, GL_FALSE, 0, (void *)0);
+        shader->setUniform(SHADER_UNIFORM_IS_TEXTURE, 1.0f);
 
-        glUniform1f(fragmentIsTextureID, 0.0f);
-    }
-
-    glBindBuffer(GL_ARRAY_BUFFER, mesh->vertexBuffer);
-    glVertexAttribPointer(vertexPosition_screenspaceID, 2, GL_FLOAT, GL_FALSE, 0, (void *)0);
-
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh->indiceBuffer);
-    glDrawElements(GL_TRIANGLES, mesh->numIndices, GL_UNSIGNED_SHORT, (void *)0);
-
-    if (mesh->hasTexture)
-    {
-        glDisableVertexAttribArray(vertexTextureUVID);
+        mesh->texture->bind(*shader, SHADER_UNIFORM_TEXTURE_SAMPLER);
     }
     else
     {
-        glDisableVertexAttribArray(vertexColourID);
+        shader->setUniform(SHADER_UNIFORM_IS_TEXTURE, 0.0f);
     }
 
-    glDisableVertexAttribArray(vertexPosition_screenspaceID);
+    mesh->bindVertexArray(*shader);
+    glDrawElements(GL_TRIANGLES, mesh->numIndices, mesh->indexType, (void *)0);
 }
 
 void Object2D::drawAll() const
@@ -103,7 +73,7 @@ Text::~Text()
 {
 }
 
-void Text::addText2D(const std::string &text, int x, int y, int size, std::shared_ptr<Texture> texture)
+MeshHandle Text::addText2D(const std::string &text, int x, int y, int size, std::shared_ptr<Texture> texture)
 {
     MeshData<glm::vec2> md;
     md.name = "text" + std::to_string(numTextStrings++);
@@ -145,7 +115,7 @@ void Text::addText2D(const std::string &text, int x, int y, int size, std::share
         i++;
     }
 
-    objData->addMesh(md);
+    return objData->addMesh(md);
 }
 
 Shape2D::Shape2D(std::shared_ptr<const Shader> _shader)
@@ -173,7 +143,7 @@ void Shape2D::addLine(glm::vec2 start, glm::vec2 end, glm::vec3 startColour, glm
             startColour, endColour, endColour, startColour);
 }
 
-void Shape2D::addRect(glm::vec2 tl, glm::vec2 tr, glm::vec2 br, glm::vec2 bl, glm::vec3 tlCol, glm::vec3 trCol, glm::vec3 brCol, glm::vec3 blCol, const std::string &name)
+MeshHandle Shape2D::addRect(glm::vec2 tl, glm::vec2 tr, glm::vec2 br, glm::vec2 bl, glm::vec3 tlCol, glm::vec3 trCol, glm::vec3 brCol, glm::vec3 blCol, const std::string &name)
 {
     MeshData<glm::vec2> md;
     if (name.size())
@@ -204,5 +174,5 @@ void Shape2D::addRect(glm::vec2 tl, glm::vec2 tr, glm::vec2 br, glm::vec2 bl, gl
     md.indices.push_back(2);
     md.indices.push_back(3);
 
-    objData->addMesh(md);
+    return objData->addMesh(md);
 }
@@ -1,15 +1,15 @@
 #ifndef __TWO_DIMENSIONAL_HPP
 #define __TWO_DIMENSIONAL_HPP
 
+#include "object_data.hpp"
+
 #include <memory>
 #include <string>
 
 #include <glm/glm.hpp>
 
 class Shader;
-class ObjData2D;
 class Texture;
-template<typename T> struct Mesh;
 
 class Object2D
 {
@@ -17,7 +17,7 @@ public:
     Object2D(std::shared_ptr<const Shader> _shader);
     ~Object2D();
 
-    void deleteObjData(const std::string &name);
+    void deleteObjData(MeshHandle handle);
     void deleteAllObjData();
 
     void drawAll() const;
@@ -35,7 +35,7 @@ public:
     Text(std::shared_ptr<const Shader> _shader);
     ~Text();
 
-    void addText2D(const std::string &text, int x, int y, int size, std::shared_ptr<Texture> texture);
+    MeshHandle addText2D(const std::string &text, int x, int y, int size, std::shared_ptr<Texture> texture);
 
 protected:
     unsigned int numTextStrings;
@@ -48,7 +48,7 @@ public:
     ~Shape2D();
 
     void addLine(glm::vec2 start, glm::vec2 end, glm::vec3 startColour, glm::vec3 endColour, float thickness);
-    void addRect(glm::vec2 tl, glm::vec2 tr, glm::vec2 br, glm::vec2 bl, glm::vec3 tlCol, glm::vec3 trCol, glm::vec3 brCol, glm::vec3 blCol, const std::string &name = "");
+    MeshHandle addRect(glm::vec2 tl, glm::vec2 tr, glm::vec2 br, glm::vec2 bl, glm::vec3 tlCol, glm::vec3 trCol, glm::vec3 brCol, glm::vec3 blCol, const std::string &name = "");
 
 protected:
     unsigned int numRects;
@@ -1,6 +1,7 @@
 #include "world.hpp"
 #include "shader.hpp"
 #include "lamp.hpp"
+#include "object_data.hpp"
 
 #include <string.h>
 
@@ -21,20 +22,55 @@ void World::sendMVP(std::shared_ptr<const Shader> shader, const glm::mat4 &model
     glm::mat4 mvp = projectionMatrix * mv;
     glm::mat3 normalMV = glm::mat3(glm::transpose(glm::inverse(mv)));
 
-    glUniformMatrix4fv(shader->getUniformID(SHADER_UNIFORM_MVP), 1, GL_FALSE, &mvp[0][0]);
+    shader->setUniform(SHADER_UNIFORM_MVP, mvp);
 
     // also send model view matrix for lightinng stuff
-    glUniformMatrix4fv(shader->getUniformID(SHADER_UNIFORM_MODEL_VIEW_MATRIX), 1, GL_FALSE, &mv[0][0]);
+    shader->setUniform(SHADER_UNIFORM_MODEL_VIEW_MATRIX, mv);
 
     // and normalMV
-    glUniformMatrix3fv(shader->getUniformID(SHADER_UNIFORM_NORMAL_MODEL_VIEW_MATRIX), 1, GL_FALSE, &normalMV[0][0]);
+    shader->setUniform(SHADER_UNIFORM_NORMAL_MODEL_VIEW_MATRIX, normalMV);
 
     // and the inverse of the projection matrix (if needed)
-    GLuint inversePID = shader->getUniformID(SHADER_UNIFORM_NORMAL_MODEL_VIEW_MATRIX);
-    if (inversePID >= 0)
+    shader->setUniform(SHADER_UNIFORM_INVERSE_PROJECTION_MATRIX, inverseProjectionMatrix);
+}
+
+bool World::isVisible(const BoundingBox<glm::vec3> &box) const
+{
+    glm::mat4 vp = projectionMatrix * viewMatrix;
+    glm::vec4 corners[8];
+    for (unsigned int i = 0; i < 8; i++)
+    {
+        corners[i] = vp * glm::vec4(box.vertices[i], 1.0f);
+    }
+
+    // it's hidden if all the corners are outside the same side of the view frustum
+    for (unsigned int axis = 0; axis < 3; axis++)
     {
-        glUniformMatrix4fv(inversePID, 1, GL_FALSE, &inverseProjectionMatrix[0][0]);
+        bool allBelow = true;
+        bool allAbove = true;
+        for (auto &c : corners)
+        {
+            if (c[axis] >= -c.w)    allBelow = false;
+            if (c[axis] <= c.w)     allAbove = false;
+        }
+        if (allBelow || allAbove)
+        {
+            return false;
+        }
     }
+    return true;
+}
+
+glm::vec3 World::getCameraPosition() const
+{
+    // the view matrix moves the camera to the origin, so undo that
+    return glm::vec3(glm::inverse(viewMatrix)[3]);
+}
+
+float World::getScreenHeightAt(float distance) const
+{
+    // [1][1] of a perspective projection is 1 / tan(fov / 2)
+    return 2.0f * distance / projectionMatrix[1][1];
 }
 
 void World::addLamp(std::shared_ptr<const ObjData3D> objData, std::shared_ptr<const ObjData3D> deferredShadingObj, std::shared_ptr<const Shader> shader,
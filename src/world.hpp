@@ -12,6 +12,7 @@
 class Shader;
 class Lamp;
 class ObjData3D;
+template<typename T> struct BoundingBox;
 
 class World
 {
@@ -30,6 +31,11 @@ public:
                  float radius, const glm::vec3 &colour, float ambient, float diffuse, float specular);
 
     void sendMVP(std::shared_ptr<const Shader> shader, const glm::mat4 &model) const;
+    // can any of box (in world co-ords) be seen by the camera
+    bool isVisible(const BoundingBox<glm::vec3> &box) const;
+    glm::vec3 getCameraPosition() const;
+    // how many world units tall the screen is, at distance away from the camera
+    float getScreenHeightAt(float distance) const;
     void sendLightingInfoToShader(std::shared_ptr<const Shader> shader) const;
     void drawLamps() const;
 